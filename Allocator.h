@@ -0,0 +1,571 @@
+#pragma once
+
+#include <memory.h>
+#include <atomic>
+#include <stdlib.h>
+#include <stddef.h>
+#include <new>
+#include <type_traits>
+
+#if defined(_MSC_VER)
+#	include <malloc.h>
+#elif defined(__APPLE__)
+#	include <malloc/malloc.h>
+#else
+#	include <malloc.h>
+#endif
+
+#if defined(__linux__)
+#	include <sys/mman.h>
+#endif
+
+#include "Compiler.h"
+
+namespace UltimaAPI
+{
+	namespace Allocator
+	{
+		template <typename alloc>	struct Traits;
+
+		struct	Heap;
+		template <size_t alignment = 64>	struct Aligned;
+		template <size_t threshold = (size_t(1) << 21), size_t alignment = 64>	struct Huge;
+		template <typename base = Heap>	struct Shared;
+		class	Arena;
+		template <typename tag = void>	struct Monotonic;
+		template <typename tag = void>	struct Pool;
+	}
+}
+
+/// <summary>
+///	Optional parts of an allocation policy.
+///	reallocate(block, bytes, al)	- grows/shrinks the block, in place if it can.
+///	usable(block, bytes)		- real size of the block, at least bytes.
+///	alignment			- alignment of the blocks, the inline container of the Vector gets it too.
+///	share(block), unique(block),
+///	release(block)			- reference counted blocks, copies of the Vector share them (copy on write).
+///	Without them the policy is used through allocate + memcpy + deallocate.
+/// </summary>
+template <typename alloc>
+struct UltimaAPI::Allocator::Traits
+{
+private:
+	template <typename a, typename = void>
+	struct	has_reallocate : std::false_type {};
+	template <typename a>
+	struct	has_reallocate<a, std::void_t<decltype(a::reallocate(nullptr, size_t(), size_t()))>> : std::true_type {};
+
+	template <typename a, typename = void>
+	struct	has_usable : std::false_type {};
+	template <typename a>
+	struct	has_usable<a, std::void_t<decltype(a::usable(nullptr, size_t()))>> : std::true_type {};
+
+	template <typename a, typename = void>
+	struct	has_alignment : std::false_type {};
+	template <typename a>
+	struct	has_alignment<a, std::void_t<decltype(a::alignment)>> : std::true_type {};
+
+	template <typename a, typename = void>
+	struct	has_share : std::false_type {};
+	template <typename a>
+	struct	has_share<a, std::void_t<decltype(a::share(nullptr))>> : std::true_type {};
+public:
+	static constexpr bool shared = has_share<alloc>::value;
+
+	/// <summary>
+	///	The block has no other owner, it can be changed in place (always for the policies without sharing).
+	/// </summary>
+	__forceinline static bool unique(void* block) noexcept
+	{
+		if constexpr (shared)
+			return alloc::unique(block);
+		else return true;
+	}
+	/// <summary>
+	///	Drops one owner, true if it was the last one: the caller ends the elements and deallocates the block.
+	/// </summary>
+	__forceinline static bool release(void* block) noexcept
+	{
+		if constexpr (shared)
+			return alloc::release(block);
+		else return true;
+	}
+	/// <summary>
+	///	Alignment of the policy, at least minimum.
+	/// </summary>
+	__forceinline static constexpr size_t alignment(size_t minimum) noexcept
+	{
+		if constexpr (has_alignment<alloc>::value)
+			return alloc::alignment > minimum ? alloc::alignment : minimum;
+		else return minimum;
+	}
+	/// <summary>
+	///	Only for trivially copyable data, the first used bytes of the block are kept.
+	/// </summary>
+	static void* reallocate(void* block, size_t bytes, size_t al, size_t used)
+	{
+		if constexpr (has_reallocate<alloc>::value)
+			return alloc::reallocate(block, bytes, al);
+		else
+		{
+			void* next = alloc::allocate(al);
+			memcpy(next, block, used < al ? used : al);
+			alloc::deallocate(block, bytes);
+			return next;
+		}
+	}
+	__forceinline static size_t usable(void* block, size_t bytes) noexcept
+	{
+		if constexpr (has_usable<alloc>::value)
+			return alloc::usable(block, bytes);
+		else return bytes;
+	}
+};
+
+/// <summary>
+///	Default allocation policy of the Vector.
+///	Every block goes to the global heap through malloc, 
+///	so the block can be extended in place by realloc (mremap for large blocks)
+///	and the slack of the malloc size class is reported by usable().
+/// </summary>
+struct UltimaAPI::Allocator::Heap
+{
+	__forceinline static void* allocate(size_t bytes)
+	{
+		if (void* block = malloc(bytes))
+			return block;
+		throw std::bad_alloc();
+	}
+	__forceinline static void deallocate(void* block, size_t /*bytes*/) noexcept
+	{
+		::free(block);
+	}
+	__forceinline static void* reallocate(void* block, size_t /*bytes*/, size_t al)
+	{
+		if (void* next = realloc(block, al))
+			return next;
+		throw std::bad_alloc();
+	}
+	__forceinline static size_t usable(void* block, size_t /*bytes*/) noexcept
+	{
+#if defined(_MSC_VER)
+		return _msize(block);
+#elif defined(__APPLE__)
+		return malloc_size(block);
+#else
+		return malloc_usable_size(block);
+#endif
+	}
+};
+
+/// <summary>
+///	Heap blocks aligned to alignment bytes (a power of two), e.g. 64 for the aligned AVX-512 loads.
+///	Aligned blocks can't be extended by realloc, they are moved by allocate + memcpy + deallocate.
+/// </summary>
+template <size_t alignment_bytes>
+struct UltimaAPI::Allocator::Aligned
+{
+	static_assert(alignment_bytes && !(alignment_bytes & (alignment_bytes - 1)), "alignment must be a power of two");
+
+	static constexpr size_t alignment = alignment_bytes < sizeof(void*) ? sizeof(void*) : alignment_bytes;
+
+	__forceinline static void* allocate(size_t bytes)
+	{
+#if defined(_MSC_VER)
+		if (void* block = _aligned_malloc(bytes, alignment))
+			return block;
+#else
+		void* block;
+		if (!posix_memalign(&block, alignment, bytes))
+			return block;
+#endif
+		throw std::bad_alloc();
+	}
+	__forceinline static void deallocate(void* block, size_t /*bytes*/) noexcept
+	{
+#if defined(_MSC_VER)
+		_aligned_free(block);
+#else
+		::free(block);
+#endif
+	}
+	__forceinline static size_t usable(void* block, size_t /*bytes*/) noexcept
+	{
+#if defined(_MSC_VER)
+		return _aligned_msize(block, alignment, 0);
+#elif defined(__APPLE__)
+		return malloc_size(block);
+#else
+		return malloc_usable_size(block);
+#endif
+	}
+};
+
+/// <summary>
+///	Aligned heap blocks below threshold bytes, larger blocks backed by transparent huge pages:
+///	whole 2 MiB pages mapped at a 2 MiB boundary and marked with madvise(MADV_HUGEPAGE),
+///	so a multi-GB vector takes one TLB entry per 2 MiB instead of per 4 KiB.
+///	The huge blocks are Linux only, elsewhere every block is Aligned.
+/// </summary>
+template <size_t threshold, size_t alignment_bytes>
+struct UltimaAPI::Allocator::Huge
+{
+	static constexpr size_t alignment = Aligned<alignment_bytes>::alignment;
+	static constexpr size_t page = size_t(1) << 21;
+private:
+	__forceinline static constexpr size_t round(size_t bytes) noexcept
+	{
+		return (bytes + page - 1) & ~(page - 1);
+	}
+	__forceinline static constexpr bool huge(size_t bytes) noexcept
+	{
+#if defined(__linux__)
+		return bytes >= threshold;
+#else
+		return false;
+#endif
+	}
+public:
+	static void* allocate(size_t bytes)
+	{
+#if defined(__linux__)
+		if (huge(bytes))
+		{
+			// the mapping is one page longer, the ends are cut off at the 2 MiB boundaries
+			size_t sz = round(bytes);
+			void* block = mmap(nullptr, sz + page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (block == MAP_FAILED)
+				throw std::bad_alloc();
+			unsigned __int8* first = static_cast<unsigned __int8*>(block);
+			unsigned __int8* aligned = reinterpret_cast<unsigned __int8*>(round(reinterpret_cast<size_t>(first)));
+			if (aligned > first)
+				munmap(first, size_t(aligned - first));
+			if (size_t tail = page - size_t(aligned - first))
+				munmap(aligned + sz, tail);
+#	if defined(MADV_HUGEPAGE)
+			madvise(aligned, sz, MADV_HUGEPAGE);
+#	endif
+			return static_cast<void*>(aligned);
+		}
+#endif
+		return Aligned<alignment_bytes>::allocate(bytes);
+	}
+	static void deallocate(void* block, size_t bytes) noexcept
+	{
+#if defined(__linux__)
+		if (huge(bytes))
+			return static_cast<void>(munmap(block, round(bytes)));
+#endif
+		Aligned<alignment_bytes>::deallocate(block, bytes);
+	}
+	/// <summary>
+	///	Huge blocks are whole pages, the Vector grows into them without a new block.
+	/// </summary>
+	static size_t usable(void* /*block*/, size_t bytes) noexcept
+	{
+		return huge(bytes) ? round(bytes) : bytes;
+	}
+};
+
+/// <summary>
+///	Reference counted blocks of base, for the copy on write Vector:
+///	the copies of a Vector<type, Shared<>> share its heap block in O(1),
+///	the first change of a copy (push_back, insert, resize, non-const operator[], data(), begin() ...) detaches it.
+///	Inline vectors are copied by value. The counter sits in front of the block,
+///	deallocate() frees the block (the Vector calls it only for the unique ones).
+/// </summary>
+template <typename base>
+struct UltimaAPI::Allocator::Shared
+{
+	static constexpr size_t alignment = Traits<base>::alignment(1);
+private:
+	struct	header
+	{
+		std::atomic<size_t> owners;
+	};
+	static constexpr size_t offset = Traits<base>::alignment(alignof(max_align_t)) > sizeof(header) ?
+		Traits<base>::alignment(alignof(max_align_t)) : sizeof(header);
+
+	__forceinline static header* head(void* block) noexcept
+	{
+		return reinterpret_cast<header*>(static_cast<unsigned __int8*>(block) - offset);
+	}
+	__forceinline static void* body(void* raw) noexcept
+	{
+		return static_cast<unsigned __int8*>(raw) + offset;
+	}
+public:
+	static void* allocate(size_t bytes)
+	{
+		void* raw = base::allocate(bytes + offset);
+		new (raw) header{ { 1 } };
+		return body(raw);
+	}
+	static void deallocate(void* block, size_t bytes) noexcept
+	{
+		header* h = head(block);
+		h->~header();
+		base::deallocate(h, bytes + offset);
+	}
+	/// <summary>
+	///	Only for the unique blocks.
+	/// </summary>
+	static void* reallocate(void* block, size_t bytes, size_t al)
+	{
+		return body(Traits<base>::reallocate(head(block), bytes + offset, al + offset, bytes + offset));
+	}
+	static size_t usable(void* block, size_t bytes) noexcept
+	{
+		return Traits<base>::usable(head(block), bytes + offset) - offset;
+	}
+
+	__forceinline static void share(void* block) noexcept
+	{
+		head(block)->owners.fetch_add(1, std::memory_order_relaxed);
+	}
+	__forceinline static bool unique(void* block) noexcept
+	{
+		return head(block)->owners.load(std::memory_order_acquire) == 1;
+	}
+	__forceinline static bool release(void* block) noexcept
+	{
+		return head(block)->owners.fetch_sub(1, std::memory_order_acq_rel) == 1;
+	}
+};
+
+/// <summary>
+///	Monotonic memory resource.
+///	Blocks are cut from large chunks by moving the cursor, nothing is returned separately.
+///	release() (or the destructor) frees all chunks at once.
+/// </summary>
+class UltimaAPI::Allocator::Arena
+{
+	struct	chunk
+	{
+		chunk* next;
+		size_t bytes;
+	};
+
+	chunk* head = nullptr;
+	unsigned __int8* cursor = nullptr, *limit = nullptr;
+	size_t chunk_bytes;
+
+	static constexpr size_t align = alignof(max_align_t);
+
+	__forceinline static constexpr size_t round(size_t bytes)
+	{
+		return (bytes + align - 1) & ~(align - 1);
+	}
+
+	decltype(auto) grow(size_t bytes)
+	{
+		size_t sz = round(sizeof(chunk)) + (bytes > chunk_bytes ? bytes : chunk_bytes);
+		chunk* next = static_cast<chunk*>(::operator new(sz));
+		next->next = head;
+		next->bytes = sz;
+		head = next;
+		cursor = reinterpret_cast<unsigned __int8*>(next) + round(sizeof(chunk));
+		limit = reinterpret_cast<unsigned __int8*>(next) + sz;
+	}
+public:
+	decltype(auto) allocate(size_t bytes)
+	{
+		bytes = round(bytes);
+		if (size_t(limit - cursor) < bytes)
+			grow(bytes);
+		void* block = cursor;
+		cursor += bytes;
+		return block;
+	}
+	/// <summary>
+	///	Only the last block can be given back (regrow chains at the top of the arena).
+	///	Any other block stays in the arena until release().
+	/// </summary>
+	decltype(auto) deallocate(void* block, size_t bytes) noexcept
+	{
+		if (static_cast<unsigned __int8*>(block) + round(bytes) == cursor)
+			cursor = static_cast<unsigned __int8*>(block);
+	}
+	/// <summary>
+	///	The last block is extended in place while the chunk has room.
+	/// </summary>
+	decltype(auto) reallocate(void* block, size_t bytes, size_t al)
+	{
+		if (static_cast<unsigned __int8*>(block) + round(bytes) == cursor && 
+			size_t(limit - static_cast<unsigned __int8*>(block)) >= round(al))
+		{
+			cursor = static_cast<unsigned __int8*>(block) + round(al);
+			return block;
+		}
+		void* next = allocate(al);
+		memcpy(next, block, bytes < al ? bytes : al);
+		deallocate(block, bytes);
+		return next;
+	}
+	__forceinline static constexpr size_t usable(size_t bytes)
+	{
+		return round(bytes);
+	}
+	decltype(auto) release() noexcept
+	{
+		while (head)
+		{
+			chunk* next = head->next;
+			::operator delete(head);
+			head = next;
+		}
+		limit = cursor = nullptr;
+	}
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	Arena(size_t chunk = 1 << 16) noexcept : chunk_bytes(chunk) {}
+	~Arena() noexcept
+	{
+		release();
+	}
+};
+
+/// <summary>
+///	Allocation policy over the Arena bound to the current thread.
+///	Bind the arena of the request with Scope, all Vector<type, Monotonic<tag>> created inside
+///	take memory from it and are freed together by Arena::release().
+///	Without a bound arena the blocks come from the thread's own arena.
+/// </summary>
+template <typename tag>
+struct UltimaAPI::Allocator::Monotonic
+{
+	static decltype(auto) current() noexcept
+	{
+		thread_local Arena* arena = nullptr;
+		return (arena);
+	}
+	static decltype(auto) fallback() noexcept
+	{
+		thread_local Arena arena;
+		return (arena);
+	}
+
+	class	Scope
+	{
+		Arena* previous;
+	public:
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+		Scope(Arena& arena) noexcept : previous(current())
+		{
+			current() = &arena;
+		}
+		~Scope() noexcept
+		{
+			current() = previous;
+		}
+	};
+
+	__forceinline static void* allocate(size_t bytes)
+	{
+		Arena* arena = current();
+		return (arena ? *arena : fallback()).allocate(bytes);
+	}
+	__forceinline static void deallocate(void* block, size_t bytes) noexcept
+	{
+		Arena* arena = current();
+		(arena ? *arena : fallback()).deallocate(block, bytes);
+	}
+	__forceinline static void* reallocate(void* block, size_t bytes, size_t al)
+	{
+		Arena* arena = current();
+		return (arena ? *arena : fallback()).reallocate(block, bytes, al);
+	}
+	__forceinline static size_t usable(void* /*block*/, size_t bytes) noexcept
+	{
+		return Arena::usable(bytes);
+	}
+};
+
+/// <summary>
+///	Allocation policy with thread local free lists by power of two size classes.
+///	Freed blocks are reused by the next allocation of the same class,
+///	blocks larger than max_bytes() go to the Heap.
+///	The blocks belong to the thread that allocated them, release() frees all of them at once.
+/// </summary>
+template <typename tag>
+struct UltimaAPI::Allocator::Pool
+{
+	__forceinline static constexpr size_t min_bytes()
+	{
+		return 16;
+	}
+	__forceinline static constexpr size_t max_bytes()
+	{
+		return 1 << 12;
+	}
+	__forceinline static constexpr size_t classes()
+	{
+		return 9; // 16 .. 4096
+	}
+private:
+	struct	node
+	{
+		node* next;
+	};
+	struct	state
+	{
+		node* free[classes()] = {};
+		Arena arena;
+	};
+
+	static decltype(auto) local() noexcept
+	{
+		thread_local state s;
+		return (s);
+	}
+	__forceinline static size_t index(size_t bytes) noexcept
+	{
+		size_t i = 0;
+		for (size_t sz = min_bytes(); sz < bytes; sz <<= 1)
+			++i;
+		return i;
+	}
+public:
+	static void* allocate(size_t bytes)
+	{
+		if (bytes > max_bytes())
+			return Heap::allocate(bytes);
+
+		state& s = local();
+		size_t i = index(bytes);
+		if (node* block = s.free[i])
+		{
+			s.free[i] = block->next;
+			return block;
+		}
+		return s.arena.allocate(min_bytes() << i);
+	}
+	static void deallocate(void* block, size_t bytes) noexcept
+	{
+		if (bytes > max_bytes())
+			return Heap::deallocate(block, bytes);
+
+		state& s = local();
+		size_t i = index(bytes);
+		static_cast<node*>(block)->next = s.free[i];
+		s.free[i] = static_cast<node*>(block);
+	}
+	/// <summary>
+	///	Blocks of the pool are the whole size class.
+	/// </summary>
+	static size_t usable(void* block, size_t bytes) noexcept
+	{
+		return bytes > max_bytes() ? Traits<Heap>::usable(block, bytes) : min_bytes() << index(bytes);
+	}
+	static void release() noexcept
+	{
+		state& s = local();
+		for (auto& list : s.free)
+			list = nullptr;
+		s.arena.release();
+	}
+};
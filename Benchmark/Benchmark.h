@@ -0,0 +1,389 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#	include <linux/perf_event.h>
+#	include <sys/ioctl.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#endif
+
+#include "../Compiler.h"
+
+namespace UltimaAPI
+{
+	namespace Benchmark
+	{
+		template <size_t bytes>	struct Element;
+		class	Counters;
+		struct	Sample;
+		struct	Options;
+		class	Suite;
+		template <typename adapter>	struct Workloads;
+
+		/// <summary>
+		///	Containers of the translation units, Vector_old can't share one with Vector.
+		/// </summary>
+		void	current(Suite& suite);
+		void	old(Suite& suite);
+	}
+}
+
+/// <summary>
+///	POD element of bytes bytes, the flat Vector_old takes only POD.
+/// </summary>
+template <size_t bytes>
+struct UltimaAPI::Benchmark::Element
+{
+	unsigned __int8 b[bytes];
+
+	static decltype(auto) make(size_t i) noexcept
+	{
+		Element e;
+		memset(e.b, int(i & 0xff), bytes);
+		return e;
+	}
+};
+
+/// <summary>
+///	Hardware counters of the calling thread (cycles, cache misses, branch misses) through perf_event_open.
+///	A counter the kernel refuses (no PMU, perf_event_paranoid, not Linux) is reported as missing.
+/// </summary>
+class UltimaAPI::Benchmark::Counters
+{
+public:
+	static constexpr size_t count = 3;
+private:
+	int fd[count] = { -1, -1, -1 };
+public:
+	static constexpr const char* names[count] = { "cycles", "cache_misses", "branch_misses" };
+
+	decltype(auto) available(size_t i) const noexcept
+	{
+		return fd[i] >= 0;
+	}
+	decltype(auto) start() noexcept
+	{
+#if defined(__linux__)
+		for (int f : fd)
+			if (f >= 0)
+			{
+				ioctl(f, PERF_EVENT_IOC_RESET, 0);
+				ioctl(f, PERF_EVENT_IOC_ENABLE, 0);
+			}
+#endif
+	}
+	/// <summary>
+	///	Stops the counters and adds their values to the totals.
+	/// </summary>
+	decltype(auto) stop(uint64_t* totals) noexcept
+	{
+#if defined(__linux__)
+		for (size_t i = 0; i < count; ++i)
+			if (fd[i] >= 0)
+			{
+				uint64_t v = 0;
+				ioctl(fd[i], PERF_EVENT_IOC_DISABLE, 0);
+				if (read(fd[i], &v, sizeof(v)) == ssize_t(sizeof(v)))
+					totals[i] += v;
+			}
+#endif
+	}
+
+	Counters(const Counters&) = delete;
+	Counters& operator=(const Counters&) = delete;
+
+	Counters() noexcept
+	{
+#if defined(__linux__)
+		const uint64_t config[count] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+		for (size_t i = 0; i < count; ++i)
+		{
+			perf_event_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.size = sizeof(attr);
+			attr.config = config[i];
+			attr.disabled = 1;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			fd[i] = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+		}
+#endif
+	}
+	~Counters() noexcept
+	{
+#if defined(__linux__)
+		for (int f : fd)
+			if (f >= 0)
+				close(f);
+#endif
+	}
+};
+
+/// <summary>
+///	One measurement: the best and the mean time of the repetitions, the counters are per repetition.
+/// </summary>
+struct UltimaAPI::Benchmark::Sample
+{
+	std::string container;
+	std::string workload;
+	size_t bytes;
+	size_t count;
+	size_t repetitions;
+	double best;
+	double mean;
+	double counters[Counters::count];
+	bool counted[Counters::count];
+};
+
+struct UltimaAPI::Benchmark::Options
+{
+	size_t max_count = 100000000;
+	size_t max_bytes = size_t(1) << 30;	// elements of one vector
+	size_t max_insert = 100000;		// middle insert is quadratic
+	double min_time = 0.05;			// seconds of repetitions per sample
+	size_t min_repetitions = 3;
+	const char* filter = nullptr;		// substring of "container/workload"
+};
+
+class UltimaAPI::Benchmark::Suite
+{
+	Options o;
+	Counters counters;
+	std::vector<Sample> samples;
+
+	static decltype(auto) escape(FILE* out, const std::string& s) noexcept
+	{
+		fputc('"', out);
+		for (char c : s)
+			if (c == '"' || c == '\\')
+				fprintf(out, "\\%c", c);
+			else fputc(c, out);
+		fputc('"', out);
+	}
+public:
+	decltype(auto) options() const noexcept
+	{
+		return (o);
+	}
+	/// <summary>
+	///	Keeps the value alive for the optimizer, the measured work can't be dropped.
+	/// </summary>
+	template <typename type>
+	__forceinline static decltype(auto) keep(type&& v) noexcept
+	{
+#if defined(_MSC_VER)
+		static volatile const void* sink;
+		sink = &v;
+#else
+		asm volatile("" : : "g"(&v) : "memory");
+#endif
+	}
+	/// <summary>
+	///	0, 1, 10, ..., 10^8 up to limit.
+	/// </summary>
+	static decltype(auto) counts(size_t limit)
+	{
+		std::vector<size_t> c{ 0 };
+		for (size_t n = 1; n <= limit && n <= 100000000; n *= 10)
+			c.push_back(n);
+		return c;
+	}
+	decltype(auto) selected(const char* container, const char* workload) const
+	{
+		return !o.filter || (std::string(container) + "/" + workload).find(o.filter) != std::string::npos;
+	}
+
+	/// <summary>
+	///	Times run() (one repetition) at least min_repetitions times and min_time seconds.
+	///	prepare() runs before every repetition, out of the time and the counters.
+	/// </summary>
+	template <typename prepare_function, typename run_function>
+	decltype(auto) measure(const char* container, const char* workload, size_t bytes, size_t count,
+		prepare_function&& prepare, run_function&& run)
+	{
+		using clock = std::chrono::steady_clock;
+		Sample s{ container, workload, bytes, count, 0, 0, 0, {}, {} };
+		uint64_t totals[Counters::count] = {};
+		double spent = 0;
+		while (s.repetitions < o.min_repetitions || spent < o.min_time)
+		{
+			prepare();
+			counters.start();
+			auto first = clock::now();
+			run();
+			auto last = clock::now();
+			counters.stop(totals);
+
+			double t = std::chrono::duration<double>(last - first).count();
+			s.best = s.repetitions ? (t < s.best ? t : s.best) : t;
+			spent += t;
+			++s.repetitions;
+		}
+		s.mean = spent / double(s.repetitions);
+		for (size_t i = 0; i < Counters::count; ++i)
+		{
+			s.counted[i] = counters.available(i);
+			s.counters[i] = double(totals[i]) / double(s.repetitions);
+		}
+		samples.push_back(s);
+	}
+	template <typename run_function>
+	decltype(auto) measure(const char* container, const char* workload, size_t bytes, size_t count, run_function&& run)
+	{
+		measure(container, workload, bytes, count, [] {}, run);
+	}
+
+	/// <summary>
+	///	Array of the samples, times in nanoseconds, missing counters are null.
+	/// </summary>
+	decltype(auto) json(FILE* out) const
+	{
+		fputs("[\n", out);
+		for (size_t i = 0; i < samples.size(); ++i)
+		{
+			const Sample& s = samples[i];
+			fputs("\t{ \"container\": ", out);
+			escape(out, s.container);
+			fputs(", \"workload\": ", out);
+			escape(out, s.workload);
+			fprintf(out, ", \"element_bytes\": %zu, \"count\": %zu, \"repetitions\": %zu, \"best_ns\": %.1f, \"mean_ns\": %.1f, \"ns_per_element\": %.3f",
+				s.bytes, s.count, s.repetitions, s.best * 1e9, s.mean * 1e9, s.best * 1e9 / double(s.count ? s.count : 1));
+			for (size_t k = 0; k < Counters::count; ++k)
+				if (s.counted[k])
+					fprintf(out, ", \"%s\": %.0f", Counters::names[k], s.counters[k]);
+				else fprintf(out, ", \"%s\": null", Counters::names[k]);
+			fputs(i + 1 < samples.size() ? " },\n" : " }\n", out);
+		}
+		fputs("]\n", out);
+	}
+
+	Suite(const Options& options) noexcept : o(options) {}
+};
+
+/// <summary>
+///	The workloads over one container, for the element sizes 1 .. 64 bytes.
+///	adapter gives the container of an element (template <typename e> using type) and the operations:
+///	push(v, x), reserve(v, n), insert(v, place, x), copy(from, to), data(v). iterate walks cbegin() .. cend().
+///	Counts are the elements of one vector (capped by max_bytes), for spill and churn the vectors created.
+/// </summary>
+template <typename adapter>
+struct UltimaAPI::Benchmark::Workloads
+{
+	/// <summary>
+	///	Elements pushed by spill, one past the 16 inline elements of the small vectors.
+	/// </summary>
+	static constexpr size_t spill_elements = 17;
+private:
+	template <typename e>
+	using vector = typename adapter::template type<e>;
+
+	template <typename e>
+	static decltype(auto) filled(size_t n)
+	{
+		vector<e> v;
+		adapter::reserve(v, n);
+		for (size_t i = 0; i < n; ++i)
+			adapter::push(v, e::make(i));
+		return v;
+	}
+
+	template <typename e>
+	static decltype(auto) run(Suite& s, const char* name)
+	{
+		const Options& o = s.options();
+		constexpr size_t bytes = sizeof(e);
+
+		for (size_t n : Suite::counts(o.max_count))
+		{
+			bool fits = n <= o.max_bytes / bytes;
+			if (fits && s.selected(name, "push_back"))
+				s.measure(name, "push_back", bytes, n, [n]
+				{
+					vector<e> v;
+					for (size_t i = 0; i < n; ++i)
+						adapter::push(v, e::make(i));
+					Suite::keep(adapter::data(v));
+				});
+			if (fits && s.selected(name, "reserve_fill"))
+				s.measure(name, "reserve_fill", bytes, n, [n]
+				{
+					vector<e> v;
+					adapter::reserve(v, n);
+					for (size_t i = 0; i < n; ++i)
+						adapter::push(v, e::make(i));
+					Suite::keep(adapter::data(v));
+				});
+			if (fits && n <= o.max_insert && s.selected(name, "middle_insert"))
+				s.measure(name, "middle_insert", bytes, n, [n]
+				{
+					vector<e> v;
+					for (size_t i = 0; i < n; ++i)
+						adapter::insert(v, i / 2, e::make(i));
+					Suite::keep(adapter::data(v));
+				});
+			if (fits && s.selected(name, "copy"))
+			{
+				vector<e> from = filled<e>(n);
+				s.measure(name, "copy", bytes, n, [&from]
+				{
+					vector<e> to;
+					adapter::copy(from, to);
+					Suite::keep(adapter::data(to));
+				});
+			}
+			if (fits && s.selected(name, "iterate"))
+			{
+				const vector<e> v = filled<e>(n);
+				s.measure(name, "iterate", bytes, n, [&v]
+				{
+					size_t sum = 0;
+					for (auto i = v.cbegin(), last = v.cend(); i != last; ++i)
+						sum += (*i).b[0];
+					Suite::keep(sum);
+				});
+			}
+			if (s.selected(name, "spill"))
+				s.measure(name, "spill", bytes, n, [n]
+				{
+					for (size_t k = 0; k < n; ++k)
+					{
+						vector<e> v;
+						for (size_t i = 0; i < spill_elements; ++i)
+							adapter::push(v, e::make(i));
+						Suite::keep(adapter::data(v));
+					}
+				});
+			if (s.selected(name, "churn"))
+				s.measure(name, "churn", bytes, n, [n]
+				{
+					for (size_t k = 0; k < n; ++k)
+					{
+						vector<e> v;
+						for (size_t i = 0, m = (k & 15) + 1; i < m; ++i)
+							adapter::push(v, e::make(i));
+						Suite::keep(adapter::data(v));
+					}
+				});
+		}
+	}
+public:
+	static decltype(auto) run(Suite& s, const char* name)
+	{
+		run<Element<1>>(s, name);
+		run<Element<2>>(s, name);
+		run<Element<4>>(s, name);
+		run<Element<8>>(s, name);
+		run<Element<16>>(s, name);
+		run<Element<32>>(s, name);
+		run<Element<64>>(s, name);
+	}
+};
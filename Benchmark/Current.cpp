@@ -0,0 +1,110 @@
+#include <vector>
+
+#if defined(__has_include)
+#	if __has_include(<boost/container/small_vector.hpp>)
+#		include <boost/container/small_vector.hpp>
+#		define ULTIMAAPI_BENCHMARK_BOOST 1
+#	endif
+#endif
+
+#include "../Vector.h"
+#include "Benchmark.h"
+
+namespace
+{
+	template <typename e>
+	using sso_vector = UltimaAPI::Vector<e>;
+	template <typename e>
+	using heap_vector = UltimaAPI::Vector<e, UltimaAPI::Allocator::Heap, 0>;
+	template <typename e>
+	using small_vector = UltimaAPI::SmallVector<e, 16>;
+	template <typename e>
+	using std_vector = std::vector<e>;
+#if defined(ULTIMAAPI_BENCHMARK_BOOST)
+	template <typename e>
+	using boost_small_vector = boost::container::small_vector<e, 16>;
+#endif
+
+	/// <summary>
+	///	Vector and SmallVector of Vector.h.
+	/// </summary>
+	template <template <typename> class container>
+	struct	Ultima
+	{
+		template <typename e>
+		using type = container<e>;
+
+		template <typename e>
+		static decltype(auto) push(type<e>& v, const e& x) noexcept
+		{
+			v.push_back(x);
+		}
+		template <typename e>
+		static decltype(auto) reserve(type<e>& v, size_t n) noexcept
+		{
+			v.reserve(n);
+		}
+		template <typename e>
+		static decltype(auto) insert(type<e>& v, size_t place, const e& x) noexcept
+		{
+			v.insert(place, x);
+		}
+		template <typename e>
+		static decltype(auto) copy(const type<e>& from, type<e>& to) noexcept
+		{
+			from.copy(&to);
+		}
+		template <typename e>
+		static decltype(auto) data(type<e>& v) noexcept
+		{
+			return v.data();
+		}
+	};
+
+	/// <summary>
+	///	std::vector and the containers with its interface.
+	/// </summary>
+	template <template <typename> class container>
+	struct	Standard
+	{
+		template <typename e>
+		using type = container<e>;
+
+		template <typename e>
+		static decltype(auto) push(type<e>& v, const e& x)
+		{
+			v.push_back(x);
+		}
+		template <typename e>
+		static decltype(auto) reserve(type<e>& v, size_t n)
+		{
+			v.reserve(n);
+		}
+		template <typename e>
+		static decltype(auto) insert(type<e>& v, size_t place, const e& x)
+		{
+			v.insert(v.begin() + ptrdiff_t(place), x);
+		}
+		template <typename e>
+		static decltype(auto) copy(const type<e>& from, type<e>& to)
+		{
+			to = from;
+		}
+		template <typename e>
+		static decltype(auto) data(type<e>& v) noexcept
+		{
+			return v.data();
+		}
+	};
+}
+
+void UltimaAPI::Benchmark::current(Suite& suite)
+{
+	Workloads<Ultima<sso_vector>>::run(suite, "Vector");
+	Workloads<Ultima<heap_vector>>::run(suite, "Vector<heap only>");
+	Workloads<Ultima<small_vector>>::run(suite, "SmallVector<16>");
+	Workloads<Standard<std_vector>>::run(suite, "std::vector");
+#if defined(ULTIMAAPI_BENCHMARK_BOOST)
+	Workloads<Standard<boost_small_vector>>::run(suite, "boost::small_vector<16>");
+#endif
+}
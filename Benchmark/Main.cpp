@@ -0,0 +1,51 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Benchmark.h"
+
+/// <summary>
+///	Benchmark [--out file.json] [--max-count n] [--max-bytes n] [--max-insert n] [--min-time seconds] [--filter container/workload]
+///	Build all .cpp of the folder with optimization, e.g. g++ -std=c++17 -O2 -DNDEBUG Benchmark/*.cpp -o benchmark
+/// </summary>
+int main(int argc, char** argv)
+{
+	UltimaAPI::Benchmark::Options o;
+	const char* path = nullptr;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const char* key = argv[i], *value = argv[i + 1];
+		if (!strcmp(key, "--out"))
+			path = value;
+		else if (!strcmp(key, "--max-count"))
+			o.max_count = size_t(strtoull(value, nullptr, 10));
+		else if (!strcmp(key, "--max-bytes"))
+			o.max_bytes = size_t(strtoull(value, nullptr, 10));
+		else if (!strcmp(key, "--max-insert"))
+			o.max_insert = size_t(strtoull(value, nullptr, 10));
+		else if (!strcmp(key, "--min-time"))
+			o.min_time = strtod(value, nullptr);
+		else if (!strcmp(key, "--filter"))
+			o.filter = value;
+		else
+		{
+			fprintf(stderr, "unknown option %s\n", key);
+			return 2;
+		}
+	}
+
+	UltimaAPI::Benchmark::Suite suite(o);
+	UltimaAPI::Benchmark::current(suite);
+	UltimaAPI::Benchmark::old(suite);
+
+	FILE* out = path ? fopen(path, "w") : stdout;
+	if (!out)
+	{
+		fprintf(stderr, "can't open %s\n", path);
+		return 1;
+	}
+	suite.json(out);
+	if (out != stdout)
+		fclose(out);
+	return 0;
+}
@@ -0,0 +1,52 @@
+#include <iterator>
+#include <type_traits>
+
+#define INCLUDE_INITIALIZER_LIST 0
+#include "../Vector_old.h"
+#include "Benchmark.h"
+
+namespace
+{
+	/// <summary>
+	///	Flat Vector_old: start, used, allocated, no inline elements.
+	/// </summary>
+	struct	Flat
+	{
+		template <typename e>
+		using type = UltimaAPI::Vector<e>;
+
+		template <typename e>
+		static decltype(auto) push(type<e>& v, const e& x) noexcept
+		{
+			v.push_back(e(x));
+		}
+		template <typename e>
+		static decltype(auto) reserve(type<e>& v, size_t n) noexcept
+		{
+			v.reserve(n);
+		}
+		template <typename e>
+		static decltype(auto) insert(type<e>& v, size_t place, const e& x) noexcept
+		{
+			v.move_insert(place, e(x));
+		}
+		/// <summary>
+		///	The const copy() of Vector_old can't be instantiated (size_value() isn't const).
+		/// </summary>
+		template <typename e>
+		static decltype(auto) copy(type<e>& from, type<e>& to) noexcept
+		{
+			from.copy(&to);
+		}
+		template <typename e>
+		static decltype(auto) data(type<e>& v) noexcept
+		{
+			return v.data();
+		}
+	};
+}
+
+void UltimaAPI::Benchmark::old(Suite& suite)
+{
+	Workloads<Flat>::run(suite, "Vector_old");
+}
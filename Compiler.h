@@ -0,0 +1,40 @@
+#pragma once
+
+#if !defined(_MSC_VER)
+#	define __forceinline	inline __attribute__((always_inline))
+#	define __int8	char
+#	define __int16	short
+#	define __int32	int
+#	define __int64	long long
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#	define ULTIMAAPI_X64
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#	define ULTIMAAPI_PRAGMA(x)	__pragma(x)
+#else
+#	define ULTIMAAPI_PRAGMA(x)	_Pragma(#x)
+#endif
+
+/// <summary>
+///	Functions between PUSH and POP keep a * b + c as two roundings (no FMA contraction),
+///	TARGET_PUSH also compiles them for the instruction set isa ("avx2", ...).
+/// </summary>
+#if defined(__clang__)
+#	define ULTIMAAPI_EXACT_PUSH	ULTIMAAPI_PRAGMA(float_control(push)) ULTIMAAPI_PRAGMA(clang fp contract(off))
+#	define ULTIMAAPI_EXACT_POP	ULTIMAAPI_PRAGMA(float_control(pop))
+#	define ULTIMAAPI_TARGET_PUSH(isa)	ULTIMAAPI_EXACT_PUSH ULTIMAAPI_PRAGMA(clang attribute push(__attribute__((target(isa))), apply_to = function))
+#	define ULTIMAAPI_TARGET_POP	ULTIMAAPI_PRAGMA(clang attribute pop) ULTIMAAPI_EXACT_POP
+#elif defined(__GNUC__)
+#	define ULTIMAAPI_EXACT_PUSH	ULTIMAAPI_PRAGMA(GCC push_options) ULTIMAAPI_PRAGMA(GCC optimize("fp-contract=off"))
+#	define ULTIMAAPI_EXACT_POP	ULTIMAAPI_PRAGMA(GCC pop_options)
+#	define ULTIMAAPI_TARGET_PUSH(isa)	ULTIMAAPI_EXACT_PUSH ULTIMAAPI_PRAGMA(GCC target(isa))
+#	define ULTIMAAPI_TARGET_POP	ULTIMAAPI_EXACT_POP
+#else
+#	define ULTIMAAPI_EXACT_PUSH	ULTIMAAPI_PRAGMA(float_control(push)) ULTIMAAPI_PRAGMA(fp_contract(off))
+#	define ULTIMAAPI_EXACT_POP	ULTIMAAPI_PRAGMA(float_control(pop))
+#	define ULTIMAAPI_TARGET_PUSH(isa)	ULTIMAAPI_EXACT_PUSH
+#	define ULTIMAAPI_TARGET_POP	ULTIMAAPI_EXACT_POP
+#endif
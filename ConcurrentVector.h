@@ -0,0 +1,222 @@
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+#include <iterator>
+#include <new>
+#include <utility>
+
+#include "Allocator.h"
+#include "Vector.h"
+
+#if defined(_MSC_VER)
+#	include <intrin.h>
+#endif
+
+namespace UltimaAPI
+{
+	template <typename type, typename allocator = Allocator::Heap, size_t first = 64>  class ConcurrentVector;
+}
+
+/// <summary>
+///	Append-only vector for many writer threads.
+///	push_back / emplace_back / grow_by reserve their slots with one atomic fetch-add, no locks.
+///	The elements live in segments of first, 2 * first, 4 * first, ... elements that are never moved,
+///	so the references stay valid while other threads append.
+///	Element i can be read by the threads that know push_back of i has returned.
+///	clear(), copy() and move() need the writers to be finished.
+///	The allocator must be usable from every writer thread (Heap, not Monotonic or Pool).
+/// </summary>
+template <typename type, typename allocator, size_t first>
+class UltimaAPI::ConcurrentVector
+{
+	static_assert(first && !(first & (first - 1)), "the first segment must be a power of two");
+
+	static constexpr size_t segments = sizeof(size_t) * 8;
+
+	alignas(64) std::atomic<size_t> used{ 0 };
+	alignas(64) std::atomic<type*> table[segments] = {};
+
+	__forceinline static size_t log2(size_t v) noexcept
+	{
+#if defined(_MSC_VER)
+		unsigned long i;
+		_BitScanReverse64(&i, v);
+		return i;
+#else
+		return sizeof(size_t) * 8 - 1 - __builtin_clzll(v);
+#endif
+	}
+	__forceinline static constexpr size_t length(size_t k) noexcept
+	{
+		return first << k;
+	}
+	/// <summary>
+	///	Index of the first element of the segment k.
+	/// </summary>
+	__forceinline static constexpr size_t base(size_t k) noexcept
+	{
+		return (first << k) - first;
+	}
+	__forceinline static size_t segment_of(size_t i) noexcept
+	{
+		return log2(i + first) - log2(first);
+	}
+
+	/// <summary>
+	///	Segment k, allocated by the first thread that needs it.
+	/// </summary>
+	decltype(auto) segment(size_t k) noexcept
+	{
+		type* s = table[k].load(std::memory_order_acquire);
+		if (!s)
+		{
+			type* fresh = static_cast<type*>(allocator::allocate(length(k) * sizeof(type)));
+			if (table[k].compare_exchange_strong(s, fresh, std::memory_order_acq_rel, std::memory_order_acquire))
+				s = fresh;
+			else allocator::deallocate(fresh, length(k) * sizeof(type));
+		}
+		return s;
+	}
+	decltype(auto) slot(size_t i) noexcept
+	{
+		size_t k = segment_of(i);
+		return segment(k) + (i - base(k));
+	}
+	/// <summary>
+	///	f(pointer, count) for the elements [0, size()) segment by segment.
+	/// </summary>
+	template <typename function>
+	decltype(auto) each(function&& f) const noexcept
+	{
+		size_t sz = size();
+		for (size_t k = 0; base(k) < sz; ++k)
+		{
+			size_t count = sz - base(k) < length(k) ? sz - base(k) : length(k);
+			f(table[k].load(std::memory_order_acquire), count);
+		}
+	}
+public:
+	template <typename... Args>
+	decltype(auto) emplace_back(Args&&... args) noexcept
+	{
+		return *new (slot(used.fetch_add(1, std::memory_order_relaxed))) type(std::forward<Args>(args)...);
+	}
+	decltype(auto) push_back(type val) noexcept
+	{
+		return emplace_back(std::move(val));
+	}
+	/// <summary>
+	///	Appends count default constructed (copies of val) elements, returns the index of the first one.
+	///	The elements may span several segments.
+	/// </summary>
+	decltype(auto) grow_by(size_t count) noexcept
+	{
+		size_t at = used.fetch_add(count, std::memory_order_relaxed);
+		for (size_t i = at; i < at + count; ++i)
+			new (slot(i)) type;
+		return at;
+	}
+	decltype(auto) grow_by(size_t count, const type& val) noexcept
+	{
+		size_t at = used.fetch_add(count, std::memory_order_relaxed);
+		for (size_t i = at; i < at + count; ++i)
+			new (slot(i)) type(val);
+		return at;
+	}
+	/// <summary>
+	///	Allocates the segments for sz elements ahead.
+	/// </summary>
+	decltype(auto) reserve(size_t sz) noexcept
+	{
+		for (size_t k = 0; base(k) < sz; ++k)
+			segment(k);
+	}
+
+	/// <summary>
+	///	Reserved slots, including the ones still being constructed by the writers.
+	/// </summary>
+	decltype(auto) size() const noexcept
+	{
+		return used.load(std::memory_order_acquire);
+	}
+	decltype(auto) empty() const noexcept
+	{
+		return size() == 0;
+	}
+	/// <summary>
+	///	Slots of all published segments, a segment published out of order (behind a gap) counts too.
+	/// </summary>
+	decltype(auto) capacity() const noexcept
+	{
+		size_t al = 0;
+		for (size_t k = 0; k < segments; ++k)
+			if (table[k].load(std::memory_order_acquire))
+				al += length(k);
+		return al;
+	}
+
+	decltype(auto) operator[](size_t i) noexcept
+	{
+		size_t k = segment_of(i);
+		return table[k].load(std::memory_order_acquire)[i - base(k)];
+	}
+	decltype(auto) operator[](size_t i) const noexcept
+	{
+		size_t k = segment_of(i);
+		return static_cast<const type&>(table[k].load(std::memory_order_acquire)[i - base(k)]);
+	}
+
+	/// <summary>
+	///	Copies the elements into the contiguous vector v, its elements are replaced.
+	/// </summary>
+	template <typename vector>
+	decltype(auto) copy(vector* v) const noexcept
+	{
+		v->clear();
+		if (size_t sz = size())
+			v->reserve(sz);
+		each([v](const type* s, size_t count) { v->append(s, count); });
+	}
+	/// <summary>
+	///	Moves the elements into the contiguous vector v (its elements are replaced) and clears this one.
+	/// </summary>
+	template <typename vector>
+	decltype(auto) move(vector* v) noexcept
+	{
+		v->clear();
+		if (size_t sz = size())
+			v->reserve(sz);
+		each([v](type* s, size_t count) { v->append(std::make_move_iterator(s), std::make_move_iterator(s + count)); });
+		clear();
+	}
+	/// <summary>
+	///	Destroys the elements, the segments are kept.
+	/// </summary>
+	decltype(auto) clear() noexcept
+	{
+		if constexpr (!std::is_trivially_destructible<type>::value)
+			each([](type* s, size_t count)
+			{
+				for (type* last = s + count; s < last; ++s)
+					s->~type();
+			});
+		used.store(0, std::memory_order_release);
+	}
+	decltype(auto) free() noexcept
+	{
+		clear();
+		for (size_t k = 0; k < segments; ++k)
+			if (type* s = table[k].exchange(nullptr, std::memory_order_acq_rel))
+				allocator::deallocate(s, length(k) * sizeof(type));
+	}
+
+	ConcurrentVector(const ConcurrentVector&) = delete;
+	ConcurrentVector& operator=(const ConcurrentVector&) = delete;
+
+	ConcurrentVector() noexcept = default;
+	~ConcurrentVector() noexcept
+	{
+		free();
+	}
+};
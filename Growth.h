@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "Compiler.h"
+
+namespace UltimaAPI
+{
+	namespace Growth
+	{
+		struct	Root;
+		struct	Half;
+		struct	Double;
+		struct	Power;
+		template <typename policy = Root>	struct SizeClass;
+	}
+}
+
+/// <summary>
+///	Growth policies of the Vector.
+///	next(allocated, needed, bytes) returns the new capacity in elements, at least needed.
+///	allocated	- current capacity
+///	needed		- elements that must fit after the growth
+///	bytes		- sizeof of the element
+/// </summary>
+
+/// <summary>
+///	x1.625, integer approximation of sqrt(e) used by the Vector before.
+/// </summary>
+struct UltimaAPI::Growth::Root
+{
+	__forceinline static constexpr size_t next(size_t allocated, size_t needed, size_t /*bytes*/) noexcept
+	{
+		size_t al = allocated + (allocated >> 1) + (allocated >> 3) + 1;
+		return al < needed ? needed : al;
+	}
+};
+
+/// <summary>
+///	x1.5, the freed blocks can be reused by the following growth.
+/// </summary>
+struct UltimaAPI::Growth::Half
+{
+	__forceinline static constexpr size_t next(size_t allocated, size_t needed, size_t /*bytes*/) noexcept
+	{
+		size_t al = allocated + (allocated >> 1) + 1;
+		return al < needed ? needed : al;
+	}
+};
+
+/// <summary>
+///	x2, the least regrowth for append-heavy vectors.
+/// </summary>
+struct UltimaAPI::Growth::Double
+{
+	__forceinline static constexpr size_t next(size_t allocated, size_t needed, size_t /*bytes*/) noexcept
+	{
+		size_t al = allocated ? allocated << 1 : 1;
+		return al < needed ? needed : al;
+	}
+};
+
+/// <summary>
+///	Capacity is always a power of two.
+/// </summary>
+struct UltimaAPI::Growth::Power
+{
+	__forceinline static constexpr size_t next(size_t allocated, size_t needed, size_t /*bytes*/) noexcept
+	{
+		size_t al = 1;
+		while (al <= allocated || al < needed)
+			al <<= 1;
+		return al;
+	}
+};
+
+/// <summary>
+///	Rounds the block of the policy up to the size classes of the allocators (malloc, Pool):
+///	16 bytes at least, then 4 classes for every power of two.
+///	The rest of the class would be lost anyway, now it is capacity.
+/// </summary>
+template <typename policy>
+struct UltimaAPI::Growth::SizeClass
+{
+	__forceinline static constexpr size_t next(size_t allocated, size_t needed, size_t bytes) noexcept
+	{
+		size_t sz = policy::next(allocated, needed, bytes) * bytes;
+		if (sz <= 16)
+			sz = 16;
+		else
+		{
+			size_t step = 1;
+			while (step << 3 < sz)
+				step <<= 1;
+			sz = (sz + step - 1) & ~(step - 1);
+		}
+		return sz / bytes;
+	}
+};
@@ -0,0 +1,333 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__has_include)
+#	if __has_include(<source_location>)
+#		include <source_location>
+#	endif
+#endif
+
+#include "Vector.h"
+
+namespace UltimaAPI
+{
+	class	CapacitySite;
+	template <typename type, typename allocator = Allocator::Heap, size_t elements = inline_elements<type>, typename growth = Growth::Root>  class LearnedVector;
+}
+
+/// <summary>
+///	Histogram of the peak sizes of the vectors created at one call site.
+///	learned() is the capacity covering 90% of the recorded vectors,
+///	table() / load() export and freeze the learned capacities of all sites.
+/// </summary>
+class UltimaAPI::CapacitySite
+{
+	static constexpr size_t buckets = sizeof(size_t) * 8 + 1;
+
+	std::string key;
+	std::atomic<size_t> histogram[buckets] = {};
+	std::atomic<size_t> frozen{ 0 };
+	CapacitySite* next = nullptr;
+
+	struct	registry
+	{
+		std::mutex lock;
+		CapacitySite* head = nullptr;
+		std::string frozen;
+	};
+	static decltype(auto) sites() noexcept
+	{
+		static registry r;
+		return (r);
+	}
+
+	__forceinline static size_t bucket(size_t sz) noexcept
+	{
+		size_t b = 0;
+		for (; sz; sz >>= 1)
+			++b;
+		return b;
+	}
+	/// <summary>
+	///	Looks for "key capacity" line of the loaded table.
+	/// </summary>
+	decltype(auto) thaw(const std::string& table) noexcept
+	{
+		for (size_t at = table.find(key); at != std::string::npos; at = table.find(key, at + 1))
+			if ((at == 0 || table[at - 1] == '\n') && table[at + key.size()] == ' ')
+			{
+				frozen = strtoull(table.c_str() + at + key.size() + 1, nullptr, 10);
+				break;
+			}
+	}
+	/// <summary>
+	///	Links the site into the registry, r.lock is held by the caller.
+	/// </summary>
+	decltype(auto) attach(registry& r) noexcept
+	{
+		thaw(r.frozen);
+		next = r.head;
+		r.head = this;
+	}
+	CapacitySite(std::string name, registry& r) : key(std::move(name))
+	{
+		attach(r);
+	}
+public:
+	decltype(auto) record(size_t peak) noexcept
+	{
+		if (!frozen.load(std::memory_order_relaxed))
+			histogram[bucket(peak)].fetch_add(1, std::memory_order_relaxed);
+	}
+	decltype(auto) learned() const noexcept
+	{
+		if (size_t al = frozen.load(std::memory_order_relaxed))
+			return al;
+
+		size_t total = 0, sum = 0;
+		for (auto& count : histogram)
+			total += count.load(std::memory_order_relaxed);
+		if (!total)
+			return size_t(0);
+
+		size_t b = 0;
+		for (; b < buckets; ++b)
+			if ((sum += histogram[b].load(std::memory_order_relaxed)) * 10 >= total * 9)
+				break;
+		return b ? size_t(-1) >> (buckets - 1 - b) : size_t(0);
+	}
+	decltype(auto) freeze(size_t capacity) noexcept
+	{
+		frozen = capacity;
+	}
+	decltype(auto) name() const noexcept
+	{
+		return key.c_str();
+	}
+
+	/// <summary>
+	///	"key capacity" line for every site that learned something.
+	/// </summary>
+	static std::string table()
+	{
+		registry& r = sites();
+		std::lock_guard<std::mutex> guard(r.lock);
+
+		std::string out;
+		char line[32];
+		for (CapacitySite* site = r.head; site; site = site->next)
+			if (size_t al = site->learned())
+			{
+				snprintf(line, sizeof(line), " %zu\n", al);
+				out += site->key;
+				out += line;
+			}
+		return out;
+	}
+	/// <summary>
+	///	Freezes the sites listed in the table (the output of table()),
+	///	the sites created later are frozen when they are created.
+	/// </summary>
+	static void load(const std::string& table)
+	{
+		registry& r = sites();
+		std::lock_guard<std::mutex> guard(r.lock);
+
+		r.frozen = table;
+		for (CapacitySite* site = r.head; site; site = site->next)
+			site->thaw(r.frozen);
+	}
+
+	/// <summary>
+	///	Site of the tag type.
+	/// </summary>
+	template <typename tag>
+	static decltype(auto) of()
+	{
+		static CapacitySite site(typeid(tag).name());
+		return (site);
+	}
+#if defined(__cpp_lib_source_location)
+	/// <summary>
+	///	Site of the caller, looked up in the registry on every call.
+	///	Keep the reference in a static local in the hot code.
+	/// </summary>
+	static decltype(auto) at(const std::source_location& where = std::source_location::current())
+	{
+		std::string key = where.file_name();
+		key += ':';
+		key += std::to_string(where.line());
+
+		registry& r = sites();
+		std::lock_guard<std::mutex> guard(r.lock);
+		for (CapacitySite* site = r.head; site; site = site->next)
+			if (site->key == key)
+				return *site;
+		return *new CapacitySite(std::move(key), r);
+	}
+#endif
+
+	CapacitySite(const CapacitySite&) = delete;
+	CapacitySite& operator=(const CapacitySite&) = delete;
+
+	CapacitySite(std::string name) : key(std::move(name))
+	{
+		registry& r = sites();
+		std::lock_guard<std::mutex> guard(r.lock);
+
+		attach(r);
+	}
+	CapacitySite(const char* file, unsigned line) : CapacitySite(std::string(file) + ':' + std::to_string(line)) {}
+	~CapacitySite() noexcept
+	{
+		registry& r = sites();
+		std::lock_guard<std::mutex> guard(r.lock);
+
+		for (CapacitySite** site = &r.head; *site; site = &(*site)->next)
+			if (*site == this)
+			{
+				*site = next;
+				break;
+			}
+	}
+};
+
+/// <summary>
+///	Site of the line where the macro is written.
+/// </summary>
+#define ULTIMAAPI_CAPACITY_SITE() \
+	([]() -> UltimaAPI::CapacitySite& { static UltimaAPI::CapacitySite site(__FILE__, __LINE__); return site; }())
+
+/// <summary>
+///	Vector reserving the capacity learned by its CapacitySite.
+///	The peak size is recorded to the site once per contents: by the destructor, or by an assignment replacing them.
+///	The peak is taken by the members of the LearnedVector that can shrink it (clear, free, pop_back, erase, resize, swap ...)
+///	and at the end, so shrink the vector through the LearnedVector, not through a Vector& to it.
+///	A moved-from vector records nothing unless it is filled again.
+/// </summary>
+template <typename type, typename allocator, size_t elements, typename growth>
+class UltimaAPI::LearnedVector : public Vector<type, allocator, elements, growth>
+{
+	using vector = Vector<type, allocator, elements, growth>;
+
+	CapacitySite* site;
+	size_t peak = 0;
+	bool moved = false;
+
+	__forceinline decltype(auto) mark() noexcept
+	{
+		if (this->size() > peak)
+			peak = this->size();
+	}
+	/// <summary>
+	///	The contents end: their peak goes to the site and the statistics start again.
+	/// </summary>
+	decltype(auto) retire() noexcept
+	{
+		mark();
+		if (peak || !moved)
+			site->record(peak);
+		peak = 0;
+		moved = false;
+	}
+	/// <summary>
+	///	v gives its peak to this vector with its elements.
+	/// </summary>
+	decltype(auto) inherit(LearnedVector& v) noexcept
+	{
+		v.mark();
+		if (v.peak > peak)
+			peak = v.peak;
+		v.peak = 0;
+		v.moved = true;
+	}
+public:
+	decltype(auto) clear() noexcept
+	{
+		mark();
+		vector::clear();
+	}
+	decltype(auto) free() noexcept
+	{
+		mark();
+		vector::free();
+	}
+	decltype(auto) pop_back() noexcept
+	{
+		mark();
+		vector::pop_back();
+	}
+	decltype(auto) erase(size_t first, size_t last) noexcept
+	{
+		mark();
+		vector::erase(first, last);
+	}
+	decltype(auto) erase(size_t i) noexcept
+	{
+		mark();
+		vector::erase(i);
+	}
+	decltype(auto) resize(size_t sz) noexcept
+	{
+		mark();
+		vector::resize(sz);
+	}
+	decltype(auto) swap(LearnedVector& v) noexcept
+	{
+		mark();
+		v.mark();
+		vector::swap(v);
+	}
+	decltype(auto) operator()(std::initializer_list<type> v) noexcept
+	{
+		mark();
+		vector::operator()(v);
+	}
+	decltype(auto) operator~() noexcept
+	{
+		free();
+	}
+	decltype(auto) operator^=(LearnedVector& v) noexcept
+	{
+		swap(v);
+	}
+
+	LearnedVector(CapacitySite& s) noexcept : site(&s)
+	{
+		if (size_t al = s.learned())
+			this->reserve(al);
+	}
+	LearnedVector(const LearnedVector& v) noexcept : vector(v), site(v.site) {}
+	LearnedVector(LearnedVector&& v) noexcept : vector(std::move(v)), site(v.site)
+	{
+		inherit(v);
+	}
+	LearnedVector& operator=(const LearnedVector& v) noexcept
+	{
+		if (&v != this)
+			retire();
+		vector::operator=(v);
+		return *this;
+	}
+	LearnedVector& operator=(LearnedVector&& v) noexcept
+	{
+		if (&v != this)
+		{
+			retire();
+			vector::operator=(std::move(v));
+			inherit(v);
+		}
+		return *this;
+	}
+
+	~LearnedVector() noexcept
+	{
+		retire();
+	}
+};
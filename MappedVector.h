@@ -0,0 +1,321 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+#include "Growth.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+namespace UltimaAPI
+{
+	template <typename type, typename growth = Growth::Double>  class MappedVector;
+}
+
+/// <summary>
+///	Vector of trivially copyable elements stored in a memory mapped file.
+///	The file is a 64 byte header (magic, version, sizeof(type), size) followed by the elements,
+///	in the byte order of the machine. The header keeps the size, the rest of the file is capacity.
+///	Read opens map the file and return at once, the pages are read on the first access.
+///	Writable vectors grow the file with ftruncate and the mapping with mremap (a new mmap out of Linux),
+///	growing throws std::bad_alloc when the file or the mapping can't be extended, the vector keeps its elements then.
+///	sync() flushes the elements and the header to the disk, close() cuts the unused capacity off the file.
+///	Elements of a read only vector must not be changed, its changing members throw std::logic_error.
+///	On a closed vector pop_back(), clear(), resize(), reserve() and shrink_to_fit() do nothing,
+///	emplace_back() and append() throw std::bad_alloc.
+/// </summary>
+template <typename type, typename growth>
+class UltimaAPI::MappedVector
+{
+	static_assert(std::is_trivially_copyable<type>::value, "MappedVector needs trivially copyable elements");
+
+	struct	header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t bytes;
+		uint64_t used;
+		unsigned __int8 pad[40];
+	};
+	static_assert(sizeof(header) == 64, "the elements start on a cache line");
+
+	static constexpr char magic[8] = { 'U', 'l', 't', 'i', 'm', 'a', 'V', 'c' };
+	static constexpr uint32_t version = 1;
+
+	int fd = -1;
+	bool writable = false;
+	header* head = nullptr;
+	size_t mapped = 0;
+
+	__forceinline static constexpr size_t bytes(size_t al) noexcept
+	{
+		return sizeof(header) + al * sizeof(type);
+	}
+	decltype(auto) start() const noexcept
+	{
+		return reinterpret_cast<type*>(head + 1);
+	}
+
+	/// <summary>
+	///	File and mapping of al elements.
+	///	On a failure the old mapping and the file length are kept.
+	/// </summary>
+	decltype(auto) remap(size_t al) noexcept
+	{
+		size_t sz = bytes(al);
+		if (ftruncate(fd, off_t(sz)))
+			return false;
+#if defined(__linux__)
+		void* next = mremap(head, mapped, sz, MREMAP_MAYMOVE);
+#else
+		void* next = mmap(nullptr, sz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (next != MAP_FAILED)
+			munmap(head, mapped);
+#endif
+		if (next == MAP_FAILED)
+		{
+			int restored = ftruncate(fd, off_t(mapped));
+			static_cast<void>(restored);
+			return false;
+		}
+		head = static_cast<header*>(next);
+		mapped = sz;
+		return true;
+	}
+	decltype(auto) allocate(size_t al)
+	{
+		if (!remap(al))
+			throw std::bad_alloc();
+	}
+	/// <summary>
+	///	false for a closed vector, throws std::logic_error for a read only one: its header is mapped read only.
+	/// </summary>
+	decltype(auto) changeable() const
+	{
+		if (head && !writable)
+			throw std::logic_error("MappedVector is open for reading only");
+		return head != nullptr;
+	}
+public:
+	enum class	Mode
+	{
+		Read,		// existing file, read only
+		Write,		// existing file or a new one
+		Truncate,	// new empty file
+	};
+
+	/// <summary>
+	///	false if the file can't be opened or isn't a MappedVector of this type.
+	/// </summary>
+	bool open(const char* path, Mode mode = Mode::Read) noexcept
+	{
+		close();
+		writable = mode != Mode::Read;
+		fd = ::open(path, writable ? O_RDWR | O_CREAT | (mode == Mode::Truncate ? O_TRUNC : 0) : O_RDONLY, 0644);
+		if (fd < 0)
+			return false;
+
+		struct stat st;
+		if (fstat(fd, &st))
+			return close(), false;
+		size_t sz = size_t(st.st_size);
+		bool created = !sz && writable;
+		if (created)
+		{
+			if (ftruncate(fd, off_t(sizeof(header))))
+				return close(), false;
+			sz = sizeof(header);
+		}
+		if (sz < sizeof(header))
+			return close(), false;
+
+		void* block = mmap(nullptr, sz, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+		if (block == MAP_FAILED)
+			return close(), false;
+		head = static_cast<header*>(block);
+		mapped = sz;
+
+		if (created)
+		{
+			memcpy(head->magic, magic, sizeof(magic));
+			head->version = version;
+			head->bytes = sizeof(type);
+			head->used = 0;
+		}
+		// a foreign file is left as it is, close() doesn't cut it
+		if (memcmp(head->magic, magic, sizeof(magic)) || head->version != version || head->bytes != sizeof(type) || head->used > (sz - sizeof(header)) / sizeof(type))
+			return writable = false, close(), false;
+		return true;
+	}
+	/// <summary>
+	///	Unmaps the file, the capacity after the last element is cut off a writable file.
+	///	false if it can't be cut, then the file keeps the capacity (the header has the size).
+	/// </summary>
+	decltype(auto) close() noexcept
+	{
+		bool cut = true;
+		if (head)
+		{
+			size_t used = size();
+			munmap(head, mapped);
+			if (writable)
+				cut = ftruncate(fd, off_t(bytes(used))) == 0;
+		}
+		if (fd >= 0)
+			::close(fd);
+		fd = -1;
+		head = nullptr;
+		mapped = 0;
+		return cut;
+	}
+	decltype(auto) is_open() const noexcept
+	{
+		return head != nullptr;
+	}
+	/// <summary>
+	///	Writes the changed pages (elements and size) to the disk and waits for them.
+	/// </summary>
+	decltype(auto) sync() noexcept
+	{
+		return !head || !writable || msync(head, mapped, MS_SYNC) == 0;
+	}
+
+	template <typename... Args>
+	decltype(auto) emplace_back(Args&&... args)
+	{
+		changeable();
+		if (size() >= capacity())
+		{
+			type val(std::forward<Args>(args)...);
+			allocate(growth::next(capacity(), size() + 1, sizeof(type)));
+			return *new (start() + head->used++) type(val);
+		}
+		return *new (start() + head->used++) type(std::forward<Args>(args)...);
+	}
+	decltype(auto) push_back(type val)
+	{
+		emplace_back(val);
+	}
+	decltype(auto) pop_back()
+	{
+		if (changeable() && size())
+			--head->used;
+	}
+	decltype(auto) append(const type* val, size_t count)
+	{
+		changeable();
+		if (size() + count > capacity())
+			allocate(growth::next(capacity(), size() + count, sizeof(type)));
+		if (count)
+		{
+			memcpy(static_cast<void*>(start() + size()), val, count * sizeof(type));
+			head->used += count;
+		}
+	}
+
+	decltype(auto) size() const noexcept
+	{
+		return head ? size_t(head->used) : size_t(0);
+	}
+	decltype(auto) capacity() const noexcept
+	{
+		return head ? (mapped - sizeof(header)) / sizeof(type) : size_t(0);
+	}
+	decltype(auto) empty() const noexcept
+	{
+		return size() == 0;
+	}
+	decltype(auto) data() noexcept
+	{
+		return start();
+	}
+	decltype(auto) data() const noexcept
+	{
+		return static_cast<const type*>(start());
+	}
+	decltype(auto) reserve(size_t sz)
+	{
+		if (changeable() && sz > capacity())
+			allocate(sz);
+	}
+	/// <summary>
+	///	New elements are zero (the file is extended with zeros).
+	/// </summary>
+	decltype(auto) resize(size_t sz)
+	{
+		if (!changeable())
+			return;
+		reserve(sz);
+		if (sz > size())
+			memset(static_cast<void*>(start() + size()), 0, (sz - size()) * sizeof(type));
+		head->used = sz;
+	}
+	decltype(auto) clear()
+	{
+		if (changeable())
+			head->used = 0;
+	}
+	decltype(auto) shrink_to_fit()
+	{
+		if (changeable() && size() < capacity())
+			allocate(size());
+	}
+
+	decltype(auto) begin() noexcept
+	{
+		return data();
+	}
+	decltype(auto) end() noexcept
+	{
+		return data() + size();
+	}
+	decltype(auto) begin() const noexcept
+	{
+		return data();
+	}
+	decltype(auto) end() const noexcept
+	{
+		return data() + size();
+	}
+	decltype(auto) operator[](size_t i) noexcept
+	{
+		return start()[i];
+	}
+	decltype(auto) operator[](size_t i) const noexcept
+	{
+		return data()[i];
+	}
+
+	MappedVector(const MappedVector&) = delete;
+	MappedVector& operator=(const MappedVector&) = delete;
+
+	MappedVector() noexcept = default;
+	MappedVector(const char* path, Mode mode = Mode::Read) noexcept
+	{
+		open(path, mode);
+	}
+	MappedVector(MappedVector&& v) noexcept : fd(v.fd), writable(v.writable), head(v.head), mapped(v.mapped)
+	{
+		v.fd = -1;
+		v.head = nullptr;
+		v.mapped = 0;
+	}
+	~MappedVector() noexcept
+	{
+		close();
+	}
+};
+
+#endif
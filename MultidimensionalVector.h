@@ -0,0 +1,329 @@
+#pragma once
+
+#include <initializer_list>
+#include <type_traits>
+
+#include "Vector.h"
+
+namespace UltimaAPI
+{
+	template <typename type>  class MultidimensionalView;
+	template <typename type, typename allocator = Allocator::Heap, typename growth = Growth::Root>  class MultidimensionalVector;
+}
+
+/// <summary>
+///	Non-owning strided view of N dimensional elements.
+///	slice() drops an axis, subview() narrows one, neither copies the elements.
+///	shape keeps the extents followed by the strides (in elements), inline up to 8 dimensions.
+/// </summary>
+template <typename type>
+class UltimaAPI::MultidimensionalView
+{
+	template <typename other>  friend class MultidimensionalView;
+	template <typename, typename, typename>  friend class MultidimensionalVector;
+
+	using shape_type = Vector<size_t, Allocator::Heap, 16>;
+
+	type* start;
+	shape_type shape;
+
+	/// <summary>
+	///	Row-major strides of the extents.
+	/// </summary>
+	static decltype(auto) contiguous(shape_type& s, const size_t* extents, size_t rank) noexcept
+	{
+		s.clear();
+		s.append(extents, rank);
+		s.resize(rank * 2);
+		for (size_t k = rank, stride = 1; k--; stride *= extents[k])
+			s[rank + k] = stride;
+	}
+public:
+	decltype(auto) rank() const noexcept
+	{
+		return shape.size() / 2;
+	}
+	decltype(auto) extent(size_t axis) const noexcept
+	{
+		return size_t(shape.data()[axis]);
+	}
+	decltype(auto) stride(size_t axis) const noexcept
+	{
+		return size_t(shape.data()[rank() + axis]);
+	}
+	/// <summary>
+	///	Number of elements (product of the extents).
+	/// </summary>
+	decltype(auto) size() const noexcept
+	{
+		size_t count = 1;
+		for (size_t k = 0; k < rank(); ++k)
+			count *= extent(k);
+		return count;
+	}
+	decltype(auto) data() const noexcept
+	{
+		return start;
+	}
+	/// <summary>
+	///	Row-major without gaps, can be reshaped.
+	/// </summary>
+	decltype(auto) contiguous() const noexcept
+	{
+		size_t expected = 1;
+		for (size_t k = rank(); k--; expected *= extent(k))
+			if (extent(k) != 1 && stride(k) != expected)
+				return false;
+		return true;
+	}
+
+	decltype(auto) offset(const size_t* index) const noexcept
+	{
+		size_t at = 0;
+		for (size_t k = 0; k < rank(); ++k)
+			at += index[k] * stride(k);
+		return at;
+	}
+	decltype(auto) at(const size_t* index) const noexcept
+	{
+		return start[offset(index)];
+	}
+	/// <summary>
+	///	Element of rank() indices.
+	/// </summary>
+	template <typename... index>
+	decltype(auto) operator()(index... i) const noexcept
+	{
+		const size_t at[] = { size_t(i)... };
+		return start[offset(at)];
+	}
+
+	/// <summary>
+	///	View without the axis, at index along it.
+	/// </summary>
+	decltype(auto) slice(size_t axis, size_t index) const noexcept
+	{
+		MultidimensionalView v(start + index * stride(axis));
+		size_t r = rank();
+		for (size_t k = 0; k < r * 2; ++k)
+			if (k % r != axis)
+				v.shape.push_back(shape.data()[k]);
+		return v;
+	}
+	/// <summary>
+	///	View of [begin, end) along the axis.
+	/// </summary>
+	decltype(auto) subview(size_t axis, size_t begin, size_t end) const noexcept
+	{
+		MultidimensionalView v(*this);
+		v.start += begin * stride(axis);
+		v.shape[axis] = end - begin;
+		return v;
+	}
+	/// <summary>
+	///	slice(0, i), a view of rank() - 1 dimensions.
+	/// </summary>
+	decltype(auto) operator[](size_t i) const noexcept
+	{
+		return slice(0, i);
+	}
+
+	/// <summary>
+	///	New extents of the same size() over a contiguous view, false if it can't be done without copying.
+	/// </summary>
+	decltype(auto) reshape(const size_t* extents, size_t rank) noexcept
+	{
+		size_t count = 1;
+		for (size_t k = 0; k < rank; ++k)
+			count *= extents[k];
+		if (count != size() || !contiguous())
+			return false;
+		contiguous(shape, extents, rank);
+		return true;
+	}
+	decltype(auto) reshape(std::initializer_list<size_t> extents) noexcept
+	{
+		return reshape(extents.begin(), extents.size());
+	}
+
+	MultidimensionalView& operator=(const MultidimensionalView& v) noexcept
+	{
+		start = v.start;
+		shape.clear();
+		shape.append(v.shape);
+		return *this;
+	}
+
+	MultidimensionalView(type* data = nullptr) noexcept : start(data) {}
+	MultidimensionalView(type* data, const size_t* extents, size_t rank) noexcept : start(data)
+	{
+		contiguous(shape, extents, rank);
+	}
+	MultidimensionalView(type* data, std::initializer_list<size_t> extents) noexcept : MultidimensionalView(data, extents.begin(), extents.size()) {}
+	MultidimensionalView(type* data, const size_t* extents, const size_t* strides, size_t rank) noexcept : start(data)
+	{
+		shape.append(extents, rank);
+		shape.append(strides, rank);
+	}
+	MultidimensionalView(const MultidimensionalView& v) noexcept : start(v.start), shape(v.shape) {}
+	/// <summary>
+	///	Mutable view to const view.
+	/// </summary>
+	template <typename other, typename = std::enable_if_t<std::is_convertible<other*, type*>::value>>
+	MultidimensionalView(const MultidimensionalView<other>& v) noexcept : start(v.start), shape(v.shape) {}
+};
+
+/// <summary>
+///	N dimensional container with the dimensions set at runtime.
+///	All elements live in one contiguous Vector in row-major order,
+///	element (i0, i1, ..., in) is at i0 * stride(0) + i1 * stride(1) + ... + in.
+///	The elements are default constructed (numbers are not zeroed), use the constructor with a value to fill them.
+/// </summary>
+template <typename type, typename allocator, typename growth>
+class UltimaAPI::MultidimensionalVector
+{
+	Vector<type, allocator, inline_elements<type>, growth> buffer;
+	MultidimensionalView<type> shape;
+
+	decltype(auto) rebind() noexcept
+	{
+		shape.start = buffer.data();
+	}
+public:
+	decltype(auto) rank() const noexcept
+	{
+		return shape.rank();
+	}
+	decltype(auto) extent(size_t axis) const noexcept
+	{
+		return shape.extent(axis);
+	}
+	decltype(auto) stride(size_t axis) const noexcept
+	{
+		return shape.stride(axis);
+	}
+	decltype(auto) size() const noexcept
+	{
+		return buffer.size();
+	}
+	decltype(auto) data() noexcept
+	{
+		return buffer.data();
+	}
+	decltype(auto) data() const noexcept
+	{
+		return buffer.data();
+	}
+
+	decltype(auto) view() noexcept
+	{
+		return shape;
+	}
+	decltype(auto) view() const noexcept
+	{
+		return MultidimensionalView<const type>(shape);
+	}
+
+	decltype(auto) at(const size_t* index) noexcept
+	{
+		return shape.at(index);
+	}
+	decltype(auto) at(const size_t* index) const noexcept
+	{
+		return static_cast<const type&>(shape.at(index));
+	}
+	template <typename... index>
+	decltype(auto) operator()(index... i) noexcept
+	{
+		return shape(i...);
+	}
+	template <typename... index>
+	decltype(auto) operator()(index... i) const noexcept
+	{
+		return static_cast<const type&>(shape(i...));
+	}
+
+	decltype(auto) slice(size_t axis, size_t index) noexcept
+	{
+		return shape.slice(axis, index);
+	}
+	decltype(auto) slice(size_t axis, size_t index) const noexcept
+	{
+		return view().slice(axis, index);
+	}
+	decltype(auto) subview(size_t axis, size_t begin, size_t end) noexcept
+	{
+		return shape.subview(axis, begin, end);
+	}
+	decltype(auto) subview(size_t axis, size_t begin, size_t end) const noexcept
+	{
+		return view().subview(axis, begin, end);
+	}
+	decltype(auto) operator[](size_t i) noexcept
+	{
+		return shape[i];
+	}
+	decltype(auto) operator[](size_t i) const noexcept
+	{
+		return view()[i];
+	}
+
+	/// <summary>
+	///	New extents of the same size(), the elements are not moved. false if the size differs.
+	/// </summary>
+	decltype(auto) reshape(const size_t* extents, size_t rank) noexcept
+	{
+		return shape.reshape(extents, rank);
+	}
+	decltype(auto) reshape(std::initializer_list<size_t> extents) noexcept
+	{
+		return shape.reshape(extents);
+	}
+	/// <summary>
+	///	New extents of any size, the elements keep their linear positions.
+	/// </summary>
+	decltype(auto) resize(const size_t* extents, size_t rank) noexcept
+	{
+		size_t count = 1;
+		for (size_t k = 0; k < rank; ++k)
+			count *= extents[k];
+		buffer.resize(count);
+		shape = MultidimensionalView<type>(buffer.data(), extents, rank);
+	}
+	decltype(auto) resize(std::initializer_list<size_t> extents) noexcept
+	{
+		resize(extents.begin(), extents.size());
+	}
+
+	MultidimensionalVector& operator=(const MultidimensionalVector& v) noexcept
+	{
+		if (&v != this)
+		{
+			buffer.clear();
+			buffer.append(v.buffer);
+			shape = v.shape;
+			rebind();
+		}
+		return *this;
+	}
+
+	MultidimensionalVector() noexcept = default;
+	MultidimensionalVector(const size_t* extents, size_t rank) noexcept
+	{
+		resize(extents, rank);
+	}
+	MultidimensionalVector(std::initializer_list<size_t> extents) noexcept
+	{
+		resize(extents);
+	}
+	MultidimensionalVector(std::initializer_list<size_t> extents, const type& value) noexcept
+	{
+		resize(extents);
+		for (size_t i = 0; i < buffer.size(); ++i)
+			buffer.data()[i] = value;
+	}
+	MultidimensionalVector(const MultidimensionalVector& v) noexcept : buffer(v.buffer), shape(v.shape)
+	{
+		rebind();
+	}
+};
@@ -0,0 +1,315 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#include "Compiler.h"
+
+namespace UltimaAPI
+{
+	class	ThreadPool;
+	struct	Parallel;
+}
+
+/// <summary>
+///	Fixed set of worker threads with a task deque per worker.
+///	A worker takes the newest task of its own deque and steals the oldest task of the others,
+///	the thread calling run() works on the tasks too until its job is done.
+/// </summary>
+class UltimaAPI::ThreadPool
+{
+	struct	task
+	{
+		void (*call)(const void* body, size_t chunk) noexcept;
+		const void* body;
+		size_t chunk;
+		std::atomic<size_t>* pending;
+	};
+	struct alignas(64) queue
+	{
+		std::mutex lock;
+		std::deque<task> tasks;
+	};
+
+	size_t count;
+	std::unique_ptr<queue[]> queues;
+	std::unique_ptr<std::thread[]> workers;
+	std::atomic<size_t> queued{ 0 };
+	std::mutex sleep;
+	std::condition_variable wake;
+	bool stop = false;
+
+	static decltype(auto) worker() noexcept
+	{
+		thread_local std::pair<const ThreadPool*, size_t> w(nullptr, 0);
+		return (w);
+	}
+	/// <summary>
+	///	Worker index of the current thread in this pool, count for other threads.
+	/// </summary>
+	decltype(auto) self() const noexcept
+	{
+		return size_t(worker().first == this ? worker().second : count);
+	}
+
+	decltype(auto) take(size_t from, task& t) noexcept
+	{
+		if (!queued.load(std::memory_order_acquire))
+			return false;
+		for (size_t i = 0; i < count; ++i)
+		{
+			queue& q = queues[(from + i) % count];
+			std::lock_guard<std::mutex> guard(q.lock);
+			if (q.tasks.empty())
+				continue;
+			if (i == 0)
+			{
+				t = q.tasks.back();
+				q.tasks.pop_back();
+			}
+			else
+			{
+				t = q.tasks.front();
+				q.tasks.pop_front();
+			}
+			queued.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+		return false;
+	}
+	__forceinline static void execute(const task& t) noexcept
+	{
+		t.call(t.body, t.chunk);
+		t.pending->fetch_sub(1, std::memory_order_release);
+	}
+	decltype(auto) loop(size_t index) noexcept
+	{
+		worker() = { this, index };
+		for (task t;;)
+		{
+			if (take(index, t))
+			{
+				execute(t);
+				continue;
+			}
+			std::unique_lock<std::mutex> guard(sleep);
+			wake.wait(guard, [this] { return stop || queued.load(std::memory_order_acquire); });
+			if (stop)
+				return;
+		}
+	}
+public:
+	/// <summary>
+	///	Pool of the parallel algorithms,
+	///	one worker less than the hardware threads, the calling thread is the last one.
+	/// </summary>
+	static decltype(auto) global()
+	{
+		static ThreadPool pool(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 0);
+		return (pool);
+	}
+
+	decltype(auto) threads() const noexcept
+	{
+		return count;
+	}
+
+	/// <summary>
+	///	Calls f(chunk) for every chunk in [0, chunks) and returns when all of them are done.
+	///	f must not throw.
+	/// </summary>
+	template <typename body>
+	void run(size_t chunks, const body& f)
+	{
+		if (chunks < 2 || !count)
+		{
+			for (size_t k = 0; k < chunks; ++k)
+				f(k);
+			return;
+		}
+
+		std::atomic<size_t> pending(chunks);
+		auto call = [](const void* b, size_t chunk) noexcept { (*static_cast<const body*>(b))(chunk); };
+		size_t from = self() % count;
+		queued.fetch_add(chunks, std::memory_order_release);
+		for (size_t w = 0; w < count; ++w)
+		{
+			queue& q = queues[(from + w) % count];
+			std::lock_guard<std::mutex> guard(q.lock);
+			for (size_t k = w; k < chunks; k += count)
+				q.tasks.push_back({ call, &f, k, &pending });
+		}
+		{
+			std::lock_guard<std::mutex> guard(sleep);
+		}
+		wake.notify_all();
+
+		for (task t; pending.load(std::memory_order_acquire);)
+			if (take(from, t))
+				execute(t);
+			else std::this_thread::yield();
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	ThreadPool(size_t threads) : count(threads), queues(new queue[threads ? threads : 1]), workers(new std::thread[threads])
+	{
+		for (size_t i = 0; i < count; ++i)
+			workers[i] = std::thread(&ThreadPool::loop, this, i);
+	}
+	~ThreadPool() noexcept
+	{
+		{
+			std::lock_guard<std::mutex> guard(sleep);
+			stop = true;
+		}
+		wake.notify_all();
+		for (size_t i = 0; i < count; ++i)
+			workers[i].join();
+	}
+};
+
+/// <summary>
+///	Parallel algorithms over contiguous elements (a Vector or a [first, last) sub-range of it).
+///	The range is cut into chunks of grain elements with the boundaries on cache lines,
+///	a range of one chunk (small and inline vectors) runs serially on the calling thread.
+/// </summary>
+struct UltimaAPI::Parallel
+{
+	struct	Options
+	{
+		size_t grain = 0;		// elements per chunk, 0 - 16 KiB of elements
+		ThreadPool* pool = nullptr;	// nullptr - ThreadPool::global()
+	};
+private:
+	template <typename type>
+	static constexpr size_t line = sizeof(type) <= 64 && 64 % sizeof(type) == 0 ? 64 / sizeof(type) : 1;
+
+	/// <summary>
+	///	n elements at first cut into chunks [begin(k), end(k)).
+	///	The first chunk ends at a cache line boundary, the others are grain elements long.
+	/// </summary>
+	struct	chunking
+	{
+		size_t n, grain, head = 0, chunks = 1;
+
+		template <typename type>
+		chunking(type* first, size_t count, const Options& o) noexcept : n(count)
+		{
+			grain = o.grain ? o.grain : (16 << 10) / sizeof(type);
+			if (!grain)
+				grain = 1;
+			grain = (grain + line<type> - 1) / line<type> * line<type>;
+			if (n <= grain)
+				return;
+
+			size_t at = reinterpret_cast<uintptr_t>(first);
+			if (at % sizeof(type) == 0)
+				head = (64 - at % 64) % 64 / sizeof(type);
+			chunks = (n - head + grain - 1) / grain;
+		}
+		decltype(auto) begin(size_t k) const noexcept
+		{
+			return k ? head + k * grain : 0;
+		}
+		decltype(auto) end(size_t k) const noexcept
+		{
+			size_t e = head + (k + 1) * grain;
+			return size_t(e < n ? e : n);
+		}
+	};
+
+	/// <summary>
+	///	Calls f(k, begin, end) for every chunk.
+	/// </summary>
+	template <typename body>
+	static void split(const chunking& c, const Options& o, const body& f)
+	{
+		if (c.chunks < 2)
+			return f(size_t(0), size_t(0), c.n);
+		(o.pool ? *o.pool : ThreadPool::global()).run(c.chunks, [&](size_t k)
+		{
+			f(k, c.begin(k), c.end(k));
+		});
+	}
+public:
+	/// <summary>
+	///	f(element) for every element.
+	/// </summary>
+	template <typename type, typename function>
+	static void for_each(type* first, type* last, function&& f, const Options& o = {})
+	{
+		split(chunking(first, size_t(last - first), o), o, [&](size_t, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+				f(first[i]);
+		});
+	}
+	template <typename vector, typename function>
+	static void for_each(vector& v, function&& f, const Options& o = {})
+	{
+		for_each(v.data(), v.data() + v.size(), f, o);
+	}
+
+	/// <summary>
+	///	dest[i] = f(first[i]), the chunks are cut on the cache lines of dest.
+	/// </summary>
+	template <typename in, typename out, typename function>
+	static void transform(const in* first, const in* last, out* dest, function&& f, const Options& o = {})
+	{
+		split(chunking(dest, size_t(last - first), o), o, [&](size_t, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+				dest[i] = f(first[i]);
+		});
+	}
+	/// <summary>
+	///	dest is resized to the size of v.
+	/// </summary>
+	template <typename vin, typename vout, typename function>
+	static void transform(const vin& v, vout& dest, function&& f, const Options& o = {})
+	{
+		dest.resize(v.size());
+		transform(v.data(), v.data() + v.size(), dest.data(), f, o);
+	}
+
+	/// <summary>
+	///	Every chunk is folded from its first element, op(partial, element),
+	///	then init and the partial results are folded in chunk order, op(result, partial).
+	///	op must be associative, the result depends on the grain but not on the threads.
+	/// </summary>
+	template <typename type, typename value, typename function>
+	static value reduce(const type* first, const type* last, value init, function&& op, const Options& o = {})
+	{
+		size_t n = size_t(last - first);
+		if (!n)
+			return init;
+
+		chunking c(first, n, o);
+		std::unique_ptr<std::optional<value>[]> partial(new std::optional<value>[c.chunks]);
+		split(c, o, [&](size_t k, size_t begin, size_t end)
+		{
+			value acc(first[begin]);
+			for (size_t i = begin + 1; i < end; ++i)
+				acc = op(std::move(acc), first[i]);
+			partial[k].emplace(std::move(acc));
+		});
+		for (size_t k = 0; k < c.chunks; ++k)
+			init = op(std::move(init), std::move(*partial[k]));
+		return init;
+	}
+	template <typename vector, typename value, typename function>
+	static value reduce(const vector& v, value init, function&& op, const Options& o = {})
+	{
+		return reduce(v.data(), v.data() + v.size(), std::move(init), op, o);
+	}
+};
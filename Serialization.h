@@ -0,0 +1,338 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#	include <errno.h>
+#	include <limits.h>
+#	include <sys/stat.h>
+#	include <sys/uio.h>
+#	include <unistd.h>
+#endif
+
+#include "Compiler.h"
+
+namespace UltimaAPI
+{
+	struct	Serializer;
+}
+
+/// <summary>
+///	Binary format of the vectors of trivially copyable elements, one record per vector:
+///	32 byte header (magic "UVec", version, byte order mark, sizeof of the element, count, checksum)
+///	followed by the count elements as they are in memory. A batch is records one after another.
+///	Records of the other byte order are loaded into arithmetic elements only, the elements are swapped.
+///	save() to a file descriptor is one writev of all the headers and payloads,
+///	load() sizes the vector once and reads into its storage (trivial elements are not zeroed before),
+///	out of a pipe or a std::istream the vector grows by 1 MiB as the payload arrives, a corrupt count fails at the end of the data.
+///	Any vector with data(), size(), clear() and resize() works (Vector, MappedVector, ...).
+/// </summary>
+struct UltimaAPI::Serializer
+{
+	struct	header
+	{
+		char magic[4];
+		uint16_t version;
+		uint16_t order;		// 0x0102 in the byte order of the writer
+		uint32_t bytes;		// sizeof of the element
+		uint32_t reserved;
+		uint64_t count;
+		uint64_t checksum;	// checksum() of the payload
+	};
+	static_assert(sizeof(header) == 32, "header is 32 bytes");
+private:
+	static constexpr char magic[4] = { 'U', 'V', 'e', 'c' };
+	static constexpr uint16_t version = 1, order = 0x0102, reversed = 0x0201;
+
+	template <typename vector>
+	using element = std::remove_cv_t<std::remove_pointer_t<decltype(std::declval<const vector&>().data())>>;
+
+	template <typename vector, typename = void>
+	struct	has_max_size : std::false_type {};
+	template <typename vector>
+	struct	has_max_size<vector, std::void_t<decltype(std::declval<const vector&>().max_size())>> : std::true_type {};
+
+	/// <summary>
+	///	Most elements the vector can hold (max_size() if it has one).
+	/// </summary>
+	template <typename vector>
+	static size_t limit(const vector& v) noexcept
+	{
+		if constexpr (has_max_size<vector>::value)
+			return size_t(v.max_size());
+		else return size_t(-1) / sizeof(element<vector>);
+	}
+
+	__forceinline static bool little() noexcept
+	{
+		uint16_t one = 1;
+		unsigned __int8 low;
+		memcpy(&low, &one, 1);
+		return low == 1;
+	}
+	template <typename type>
+	__forceinline static type swapped(type v) noexcept
+	{
+		unsigned __int8 b[sizeof(type)];
+		memcpy(b, &v, sizeof(type));
+		for (size_t i = 0; i < sizeof(type) / 2; ++i)
+		{
+			unsigned __int8 t = b[i];
+			b[i] = b[sizeof(type) - 1 - i];
+			b[sizeof(type) - 1 - i] = t;
+		}
+		memcpy(&v, b, sizeof(type));
+		return v;
+	}
+
+	template <typename vector>
+	static header describe(const vector& v) noexcept
+	{
+		header h = {};
+		memcpy(h.magic, magic, sizeof(magic));
+		h.version = version;
+		h.order = order;
+		h.bytes = sizeof(element<vector>);
+		h.count = v.size();
+		h.checksum = checksum(v.data(), v.size() * sizeof(element<vector>));
+		return h;
+	}
+	/// <summary>
+	///	Checks the header read before the payload, swaps its fields to this byte order.
+	/// </summary>
+	template <typename type>
+	static bool accept(header& h, bool& swap) noexcept
+	{
+		swap = h.order == reversed;
+		if (memcmp(h.magic, magic, sizeof(magic)) || (h.order != order && !swap))
+			return false;
+		if (swap)
+		{
+			h.version = swapped(h.version);
+			h.bytes = swapped(h.bytes);
+			h.count = swapped(h.count);
+			h.checksum = swapped(h.checksum);
+		}
+		return h.version == version && h.bytes == sizeof(type) && (!swap || std::is_arithmetic<type>::value);
+	}
+	/// <summary>
+	///	Reads the count elements of the payload into v through read(to, bytes).
+	///	step elements at a time, the vector grows only as far as the data goes.
+	/// </summary>
+	template <typename vector, typename reader>
+	static bool receive(vector& v, size_t count, size_t step, reader&& read)
+	{
+		v.clear();
+		for (size_t done = 0; done < count;)
+		{
+			size_t n = count - done < step ? count - done : step;
+			v.resize(done + n);
+			if (!read(v.data() + done, n * sizeof(element<vector>)))
+			{
+				v.clear();
+				return false;
+			}
+			done += n;
+		}
+		return true;
+	}
+	/// <summary>
+	///	Elements read at a time from a source of unknown length.
+	/// </summary>
+	template <typename vector>
+	static constexpr size_t chunk = (size_t(1) << 20) / sizeof(element<vector>) + 1;
+	/// <summary>
+	///	Verifies the payload read into v and swaps its elements.
+	/// </summary>
+	template <typename vector>
+	static bool verify(vector& v, const header& h, bool swap) noexcept
+	{
+		if (checksum(v.data(), v.size() * sizeof(element<vector>)) != h.checksum)
+		{
+			v.clear();
+			return false;
+		}
+		if (swap)
+			for (size_t i = 0; i < v.size(); ++i)
+				v.data()[i] = swapped(v.data()[i]);
+		return true;
+	}
+
+#if defined(__unix__) || defined(__APPLE__)
+	static bool write_all(int fd, iovec* io, size_t count) noexcept
+	{
+#	if defined(IOV_MAX)
+		constexpr size_t limit = IOV_MAX;
+#	else
+		constexpr size_t limit = 1024;
+#	endif
+		while (count)
+		{
+			ssize_t written = ::writev(fd, io, int(count < limit ? count : limit));
+			if (written < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				return false;
+			}
+			size_t w = size_t(written);
+			for (; count && w >= io->iov_len; --count, ++io)
+				w -= io->iov_len;
+			if (count && w)
+			{
+				io->iov_base = static_cast<unsigned __int8*>(io->iov_base) + w;
+				io->iov_len -= w;
+			}
+		}
+		return true;
+	}
+	static bool read_all(int fd, void* to, size_t bytes) noexcept
+	{
+		for (unsigned __int8* at = static_cast<unsigned __int8*>(to); bytes;)
+		{
+			ssize_t got = ::read(fd, at, bytes);
+			if (got < 0 && errno == EINTR)
+				continue;
+			if (got <= 0)
+				return false;
+			at += got;
+			bytes -= size_t(got);
+		}
+		return true;
+	}
+	template <typename vector>
+	static bool load_one(int fd, vector& v) noexcept
+	{
+		header h;
+		bool swap;
+		if (!read_all(fd, &h, sizeof(h)) || !accept<element<vector>>(h, swap) || h.count > limit(v))
+			return false;
+
+		// a regular file must hold the payload, the vector is sized once
+		struct stat st;
+		off_t at;
+		size_t step = chunk<vector>;
+		if (!fstat(fd, &st) && S_ISREG(st.st_mode) && (at = lseek(fd, 0, SEEK_CUR)) >= 0)
+		{
+			if (st.st_size < at || h.count > size_t(st.st_size - at) / sizeof(element<vector>))
+				return false;
+			step = size_t(h.count);
+		}
+		return receive(v, size_t(h.count), step, [fd](void* to, size_t bytes) { return read_all(fd, to, bytes); }) &&
+			verify(v, h, swap);
+	}
+#endif
+
+	template <typename vector>
+	static bool load_one(std::istream& is, vector& v)
+	{
+		header h;
+		bool swap;
+		if (!is.read(reinterpret_cast<char*>(&h), sizeof(h)) || !accept<element<vector>>(h, swap) || h.count > limit(v))
+			return false;
+		return receive(v, size_t(h.count), chunk<vector>,
+			[&is](void* to, size_t bytes) { return bool(is.read(static_cast<char*>(to), std::streamsize(bytes))); }) &&
+			verify(v, h, swap);
+	}
+public:
+	/// <summary>
+	///	h = 0xcbf29ce484222325, then for every little endian 8 byte word w of the data
+	///	(the last 1..7 bytes zero padded to a word): h = (h ^ w) * 0x9e3779b97f4a7c15, h ^= h >> 32.
+	///	The result is h ^ bytes.
+	/// </summary>
+	static uint64_t checksum(const void* data, size_t bytes) noexcept
+	{
+		const unsigned __int8* p = static_cast<const unsigned __int8*>(data);
+		uint64_t h = 0xcbf29ce484222325ull, w;
+		bool le = little();
+		size_t left = bytes;
+		for (; left >= 8; p += 8, left -= 8)
+		{
+			memcpy(&w, p, 8);
+			h = (h ^ (le ? w : swapped(w))) * 0x9e3779b97f4a7c15ull;
+			h ^= h >> 32;
+		}
+		if (left)
+		{
+			w = 0;
+			for (size_t i = 0; i < left; ++i)
+				w |= uint64_t(p[i]) << (i * 8);
+			h = (h ^ w) * 0x9e3779b97f4a7c15ull;
+			h ^= h >> 32;
+		}
+		return h ^ bytes;
+	}
+
+#if defined(__unix__) || defined(__APPLE__)
+	/// <summary>
+	///	Records of all the vectors in one writev.
+	/// </summary>
+	template <typename... vectors>
+	static bool save(int fd, const vectors&... v) noexcept
+	{
+		static_assert((std::is_trivially_copyable<element<vectors>>::value && ...), "Serializer needs trivially copyable elements");
+		header h[] = { describe(v)... };
+		iovec io[sizeof...(v) * 2];
+		size_t i = 0;
+		((io[i] = { &h[i / 2], sizeof(header) },
+			io[i + 1] = { const_cast<element<vectors>*>(v.data()), v.size() * sizeof(element<vectors>) },
+			i += 2), ...);
+		return write_all(fd, io, i);
+	}
+	/// <summary>
+	///	Records of count vectors of one type, in one writev (split by IOV_MAX).
+	/// </summary>
+	template <typename vector>
+	static bool save_all(int fd, const vector* v, size_t count)
+	{
+		static_assert(std::is_trivially_copyable<element<vector>>::value, "Serializer needs trivially copyable elements");
+		std::unique_ptr<header[]> h(new header[count]);
+		std::unique_ptr<iovec[]> io(new iovec[count * 2]);
+		for (size_t i = 0; i < count; ++i)
+		{
+			h[i] = describe(v[i]);
+			io[i * 2] = { &h[i], sizeof(header) };
+			io[i * 2 + 1] = { const_cast<element<vector>*>(v[i].data()), v[i].size() * sizeof(element<vector>) };
+		}
+		return write_all(fd, io.get(), count * 2);
+	}
+	/// <summary>
+	///	Reads the records into the vectors in order, false at the first bad record.
+	/// </summary>
+	template <typename... vectors>
+	static bool load(int fd, vectors&... v) noexcept
+	{
+		return (load_one(fd, v) && ...);
+	}
+	template <typename vector>
+	static bool load_all(int fd, vector* v, size_t count) noexcept
+	{
+		for (size_t i = 0; i < count; ++i)
+			if (!load_one(fd, v[i]))
+				return false;
+		return true;
+	}
+#endif
+
+	template <typename... vectors>
+	static bool save(std::ostream& os, const vectors&... v)
+	{
+		static_assert((std::is_trivially_copyable<element<vectors>>::value && ...), "Serializer needs trivially copyable elements");
+		header h[] = { describe(v)... };
+		size_t i = 0;
+		((os.write(reinterpret_cast<const char*>(&h[i++]), sizeof(header)),
+			os.write(reinterpret_cast<const char*>(v.data()), std::streamsize(v.size() * sizeof(element<vectors>)))), ...);
+		return bool(os);
+	}
+	template <typename... vectors>
+	static bool load(std::istream& is, vectors&... v)
+	{
+		return (load_one(is, v) && ...);
+	}
+};
@@ -0,0 +1,924 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "Compiler.h"
+
+#if defined(ULTIMAAPI_X64)
+#	if defined(_MSC_VER)
+#		include <intrin.h>
+#	endif
+#	include <immintrin.h>
+#endif
+
+namespace UltimaAPI
+{
+	struct	Simd;
+
+	namespace Kernel
+	{
+		struct	Scalar;
+#if defined(ULTIMAAPI_X64)
+		struct	Sse2;
+		struct	Avx2;
+		struct	Avx512;
+#endif
+	}
+}
+
+ULTIMAAPI_EXACT_PUSH
+
+/// <summary>
+///	Portable kernels, they define the results of all the other kernels.
+///	sum / dot of floating point types go through lanes<type> = 64 / sizeof(type) partial sums:
+///	element i is added to lane i % lanes in index order (a product of dot is rounded before the addition),
+///	then the lanes are folded by halves, lane[j] += lane[j + w] for w = lanes / 2, ..., 2, 1, the result is lane[0].
+///	min / max run the same lanes with x < m ? x : m (x > m ? x : m), so NaN elements are skipped.
+///	Integer sum / dot wrap modulo 2^64, any order gives the same result.
+/// </summary>
+struct UltimaAPI::Kernel::Scalar
+{
+	template <typename type>
+	static constexpr size_t lanes = 64 / sizeof(type);
+
+	template <typename type>
+	using accumulator = std::conditional_t<std::is_floating_point<type>::value, type,
+		std::conditional_t<std::is_signed<type>::value, int64_t, uint64_t>>;
+
+	__forceinline static size_t popcount(uint64_t mask) noexcept
+	{
+		mask -= (mask >> 1) & 0x5555555555555555ull;
+		mask = (mask & 0x3333333333333333ull) + ((mask >> 2) & 0x3333333333333333ull);
+		return size_t((((mask + (mask >> 4)) & 0x0f0f0f0f0f0f0f0full) * 0x0101010101010101ull) >> 56);
+	}
+	__forceinline static size_t ctz(uint64_t mask) noexcept
+	{
+		return popcount((mask & (0 - mask)) - 1);
+	}
+	template <typename type, bool greater>
+	__forceinline static constexpr type identity() noexcept
+	{
+		if constexpr (std::numeric_limits<type>::has_infinity)
+			return greater ? -std::numeric_limits<type>::infinity() : std::numeric_limits<type>::infinity();
+		else return greater ? std::numeric_limits<type>::lowest() : (std::numeric_limits<type>::max)();
+	}
+	template <typename type, bool greater>
+	__forceinline static type pick(type x, type m) noexcept
+	{
+		if constexpr (greater)
+			return x > m ? x : m;
+		else return x < m ? x : m;
+	}
+
+	template <typename type>
+	static size_t find(const type* data, size_t n, type value) noexcept
+	{
+		size_t i = 0;
+		for (; i < n; ++i)
+			if (data[i] == value)
+				break;
+		return i;
+	}
+	template <typename type>
+	static size_t count(const type* data, size_t n, type value) noexcept
+	{
+		size_t c = 0;
+		for (size_t i = 0; i < n; ++i)
+			c += data[i] == value;
+		return c;
+	}
+
+	/// <summary>
+	///	Continues the lanes with data starting at a multiple of lanes<type> and folds them.
+	/// </summary>
+	template <typename type, bool greater>
+	static type extreme(type* lane, const type* data, size_t n) noexcept
+	{
+		for (size_t i = 0; i < n; ++i)
+			lane[i % lanes<type>] = pick<type, greater>(data[i], lane[i % lanes<type>]);
+		for (size_t w = lanes<type> / 2; w; w /= 2)
+			for (size_t j = 0; j < w; ++j)
+				lane[j] = pick<type, greater>(lane[j + w], lane[j]);
+		return lane[0];
+	}
+	template <typename type, bool greater>
+	static type extreme(const type* data, size_t n) noexcept
+	{
+		type lane[lanes<type>];
+		for (auto& l : lane)
+			l = identity<type, greater>();
+		return extreme<type, greater>(lane, data, n);
+	}
+
+	/// <summary>
+	///	Continues the lanes with data starting at a multiple of lanes<type> and folds them.
+	/// </summary>
+	template <typename type>
+	static type sum(type* lane, const type* data, size_t n) noexcept
+	{
+		for (size_t i = 0; i < n; ++i)
+			lane[i % lanes<type>] += data[i];
+		return fold(lane);
+	}
+	template <typename type>
+	static accumulator<type> sum(const type* data, size_t n) noexcept
+	{
+		if constexpr (std::is_floating_point<type>::value)
+		{
+			type lane[lanes<type>] = {};
+			return sum(lane, data, n);
+		}
+		else
+		{
+			uint64_t total = 0;
+			for (size_t i = 0; i < n; ++i)
+				total += uint64_t(accumulator<type>(data[i]));
+			return accumulator<type>(total);
+		}
+	}
+
+	/// <summary>
+	///	Continues the lanes with data starting at a multiple of lanes<type> and folds them.
+	/// </summary>
+	template <typename type>
+	static type dot(type* lane, const type* a, const type* b, size_t n) noexcept
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			type product = a[i] * b[i];
+			lane[i % lanes<type>] += product;
+		}
+		return fold(lane);
+	}
+	template <typename type>
+	static accumulator<type> dot(const type* a, const type* b, size_t n) noexcept
+	{
+		if constexpr (std::is_floating_point<type>::value)
+		{
+			type lane[lanes<type>] = {};
+			return dot(lane, a, b, n);
+		}
+		else
+		{
+			uint64_t total = 0;
+			for (size_t i = 0; i < n; ++i)
+				total += uint64_t(accumulator<type>(a[i]) * accumulator<type>(b[i]));
+			return accumulator<type>(total);
+		}
+	}
+private:
+	template <typename type>
+	__forceinline static type fold(type* lane) noexcept
+	{
+		for (size_t w = lanes<type> / 2; w; w /= 2)
+			for (size_t j = 0; j < w; ++j)
+				lane[j] += lane[j + w];
+		return lane[0];
+	}
+};
+
+ULTIMAAPI_EXACT_POP
+
+#if defined(ULTIMAAPI_X64)
+
+ULTIMAAPI_TARGET_PUSH("sse2")
+
+/// <summary>
+///	16 byte kernels.
+///	dot of int32_t needs the signed multiply of SSE4.1 and stays scalar.
+/// </summary>
+struct UltimaAPI::Kernel::Sse2
+{
+	template <typename type, typename = void>
+	struct	vec { using reg = __m128i; };
+	template <typename unused>
+	struct	vec<float, unused> { using reg = __m128; };
+
+	template <typename type>
+	using reg = typename vec<type>::reg;
+	template <typename type>
+	static constexpr size_t lanes = sizeof(reg<type>) / sizeof(type);
+
+	template <typename type>
+	__forceinline static reg<type> load(const type* p) noexcept
+	{
+		if constexpr (std::is_same<type, float>::value)
+			return _mm_loadu_ps(p);
+		else return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+	}
+	template <typename type>
+	__forceinline static void store(type* p, reg<type> r) noexcept
+	{
+		if constexpr (std::is_same<type, float>::value)
+			_mm_storeu_ps(p, r);
+		else _mm_storeu_si128(reinterpret_cast<__m128i*>(p), r);
+	}
+	template <typename type>
+	__forceinline static reg<type> splat(type value) noexcept
+	{
+		if constexpr (std::is_same<type, float>::value)
+			return _mm_set1_ps(value);
+		else if constexpr (sizeof(type) == 4)
+			return _mm_set1_epi32(value);
+		else return _mm_set1_epi8(char(value));
+	}
+	/// <summary>
+	///	Bit per lane where a == b.
+	/// </summary>
+	template <typename type>
+	__forceinline static uint64_t equal(reg<type> a, reg<type> b) noexcept
+	{
+		if constexpr (std::is_same<type, float>::value)
+			return unsigned(_mm_movemask_ps(_mm_cmpeq_ps(a, b)));
+		else if constexpr (sizeof(type) == 4)
+			return unsigned(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b))));
+		else return unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)));
+	}
+	template <typename type, bool greater>
+	__forceinline static reg<type> pick(reg<type> x, reg<type> m) noexcept
+	{
+		if constexpr (std::is_same<type, float>::value)
+			return greater ? _mm_max_ps(x, m) : _mm_min_ps(x, m);
+		else if constexpr (sizeof(type) == 4)
+		{
+			__m128i take = greater ? _mm_cmpgt_epi32(x, m) : _mm_cmplt_epi32(x, m);
+			return _mm_or_si128(_mm_and_si128(take, x), _mm_andnot_si128(take, m));
+		}
+		else return greater ? _mm_max_epu8(x, m) : _mm_min_epu8(x, m);
+	}
+	__forceinline static uint64_t total(__m128i acc) noexcept
+	{
+		uint64_t t[2];
+		store(t, acc);
+		return t[0] + t[1];
+	}
+
+	template <typename type>
+	static size_t find(const type* data, size_t n, type value) noexcept
+	{
+		reg<type> v = splat(value);
+		size_t i = 0;
+		for (; i + lanes<type> <= n; i += lanes<type>)
+			if (uint64_t hit = equal<type>(load(data + i), v))
+				return i + Scalar::ctz(hit);
+		return i + Scalar::find(data + i, n - i, value);
+	}
+	template <typename type>
+	static size_t count(const type* data, size_t n, type value) noexcept
+	{
+		reg<type> v = splat(value);
+		size_t c = 0, i = 0;
+		for (; i + lanes<type> <= n; i += lanes<type>)
+			c += Scalar::popcount(equal<type>(load(data + i), v));
+		return c + Scalar::count(data + i, n - i, value);
+	}
+	template <typename type, bool greater>
+	static type extreme(const type* data, size_t n) noexcept
+	{
+		constexpr size_t width = Scalar::lanes<type>, k = width / lanes<type>;
+		reg<type> acc[k];
+		for (auto& a : acc)
+			a = splat(Scalar::identity<type, greater>());
+		size_t i = 0;
+		for (; i + width <= n; i += width)
+			for (size_t j = 0; j < k; ++j)
+				acc[j] = pick<type, greater>(load(data + i + j * lanes<type>), acc[j]);
+		type lane[width];
+		for (size_t j = 0; j < k; ++j)
+			store(lane + j * lanes<type>, acc[j]);
+		return Scalar::extreme<type, greater>(lane, data + i, n - i);
+	}
+
+	static float sum(const float* data, size_t n) noexcept
+	{
+		constexpr size_t width = Scalar::lanes<float>, k = width / lanes<float>;
+		__m128 acc[k];
+		for (auto& a : acc)
+			a = _mm_setzero_ps();
+		size_t i = 0;
+		for (; i + width <= n; i += width)
+			for (size_t j = 0; j < k; ++j)
+				acc[j] = _mm_add_ps(acc[j], load(data + i + j * lanes<float>));
+		float lane[width];
+		for (size_t j = 0; j < k; ++j)
+			store(lane + j * lanes<float>, acc[j]);
+		return Scalar::sum(lane, data + i, n - i);
+	}
+	static int64_t sum(const int32_t* data, size_t n) noexcept
+	{
+		__m128i acc = _mm_setzero_si128();
+		size_t i = 0;
+		for (; i + lanes<int32_t> <= n; i += lanes<int32_t>)
+		{
+			__m128i x = load(data + i), sign = _mm_srai_epi32(x, 31);
+			acc = _mm_add_epi64(acc, _mm_add_epi64(_mm_unpacklo_epi32(x, sign), _mm_unpackhi_epi32(x, sign)));
+		}
+		return int64_t(total(acc) + uint64_t(Scalar::sum(data + i, n - i)));
+	}
+	static uint64_t sum(const uint8_t* data, size_t n) noexcept
+	{
+		__m128i acc = _mm_setzero_si128(), zero = _mm_setzero_si128();
+		size_t i = 0;
+		for (; i + lanes<uint8_t> <= n; i += lanes<uint8_t>)
+			acc = _mm_add_epi64(acc, _mm_sad_epu8(load(data + i), zero));
+		return total(acc) + Scalar::sum(data + i, n - i);
+	}
+
+	static float dot(const float* a, const float* b, size_t n) noexcept
+	{
+		constexpr size_t width = Scalar::lanes<float>, k = width / lanes<float>;
+		__m128 acc[k];
+		for (auto& r : acc)
+			r = _mm_setzero_ps();
+		size_t i = 0;
+		for (; i + width <= n; i += width)
+			for (size_t j = 0; j < k; ++j)
+				acc[j] = _mm_add_ps(acc[j], _mm_mul_ps(load(a + i + j * lanes<float>), load(b + i + j * lanes<float>)));
+		float lane[width];
+		for (size_t j = 0; j < k; ++j)
+			store(lane + j * lanes<float>, acc[j]);
+		return Scalar::dot(lane, a + i, b + i, n - i);
+	}
+	static int64_t dot(const int32_t* a, const int32_t* b, size_t n) noexcept
+	{
+		return Scalar::dot(a, b, n);
+	}
+	/// <summary>
+	///	Products are summed in 32 bit lanes for 8192 steps (4 * 255 * 255 per step), then widened.
+	/// </summary>
+	static uint64_t dot(const uint8_t* a, const uint8_t* b, size_t n) noexcept
+	{
+		constexpr size_t step = lanes<uint8_t>, limit = step * 8192;
+		__m128i acc = _mm_setzero_si128(), zero = _mm_setzero_si128();
+		size_t i = 0;
+		while (n - i >= step)
+		{
+			size_t end = i + ((n - i < limit ? n - i : limit) / step) * step;
+			__m128i part = zero;
+			for (; i < end; i += step)
+			{
+				__m128i x = load(a + i), y = load(b + i);
+				part = _mm_add_epi32(part, _mm_add_epi32(
+					_mm_madd_epi16(_mm_unpacklo_epi8(x, zero), _mm_unpacklo_epi8(y, zero)),
+					_mm_madd_epi16(_mm_unpackhi_epi8(x, zero), _mm_unpackhi_epi8(y, zero))));
+			}
+			acc = _mm_add_epi64(acc, _mm_add_epi64(_mm_unpacklo_epi32(part, zero), _mm_unpackhi_epi32(part, zero)));
+		}
+		return total(acc) + Scalar::dot(a + i, b + i, n - i);
+	}
+};
+
+ULTIMAAPI_TARGET_POP
+
+ULTIMAAPI_TARGET_PUSH("avx2")
+
+/// <summary>
+///	32 byte kernels.
+/// </summary>
+struct UltimaAPI::Kernel::Avx2
+{
+	template <typename type, typename = void>
+	struct	vec { using reg = __m256i; };
+	template <typename unused>
+	struct	vec<float, unused> { using reg = __m256; };
+
+	template <typename type>
+	using reg = typename vec<type>::reg;
+	template <typename type>
+	static constexpr size_t lanes = sizeof(reg<type>) / sizeof(type);
+
+	template <typename type>
+	__forceinline static reg<type> load(const type* p) noexcept
+	{
+		if constexpr (std::is_same<type, float>::value)
+			return _mm256_loadu_ps(p);
+		else return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+	}
+	template <typename type>
+	__forceinline static void store(type* p, reg<type> r) noexcept
+	{
+		if constexpr (std::is_same<type, float>::value)
+			_mm256_storeu_ps(p, r);
+		else _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), r);
+	}
+	template <typename type>
+	__forceinline static reg<type> splat(type value) noexcept
+	{
+		if constexpr (std::is_same<type, float>::value)
+			return _mm256_set1_ps(value);
+		else if constexpr (sizeof(type) == 4)
+			return _mm256_set1_epi32(value);
+		else return _mm256_set1_epi8(char(value));
+	}
+	/// <summary>
+	///	Bit per lane where a == b.
+	/// </summary>
+	template <typename type>
+	__forceinline static uint64_t equal(reg<type> a, reg<type> b) noexcept
+	{
+		if constexpr (std::is_same<type, float>::value)
+			return unsigned(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ)));
+		else if constexpr (sizeof(type) == 4)
+			return unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b))));
+		else return unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)));
+	}
+	template <typename type, bool greater>
+	__forceinline static reg<type> pick(reg<type> x, reg<type> m) noexcept
+	{
+		if constexpr (std::is_same<type, float>::value)
+			return greater ? _mm256_max_ps(x, m) : _mm256_min_ps(x, m);
+		else if constexpr (sizeof(type) == 4)
+			return greater ? _mm256_max_epi32(x, m) : _mm256_min_epi32(x, m);
+		else return greater ? _mm256_max_epu8(x, m) : _mm256_min_epu8(x, m);
+	}
+	__forceinline static uint64_t total(__m256i acc) noexcept
+	{
+		uint64_t t[4];
+		store(t, acc);
+		return t[0] + t[1] + t[2] + t[3];
+	}
+
+	template <typename type>
+	static size_t find(const type* data, size_t n, type value) noexcept
+	{
+		reg<type> v = splat(value);
+		size_t i = 0;
+		for (; i + lanes<type> <= n; i += lanes<type>)
+			if (uint64_t hit = equal<type>(load(data + i), v))
+				return i + Scalar::ctz(hit);
+		return i + Scalar::find(data + i, n - i, value);
+	}
+	template <typename type>
+	static size_t count(const type* data, size_t n, type value) noexcept
+	{
+		reg<type> v = splat(value);
+		size_t c = 0, i = 0;
+		for (; i + lanes<type> <= n; i += lanes<type>)
+			c += Scalar::popcount(equal<type>(load(data + i), v));
+		return c + Scalar::count(data + i, n - i, value);
+	}
+	template <typename type, bool greater>
+	static type extreme(const type* data, size_t n) noexcept
+	{
+		constexpr size_t width = Scalar::lanes<type>, k = width / lanes<type>;
+		reg<type> acc[k];
+		for (auto& a : acc)
+			a = splat(Scalar::identity<type, greater>());
+		size_t i = 0;
+		for (; i + width <= n; i += width)
+			for (size_t j = 0; j < k; ++j)
+				acc[j] = pick<type, greater>(load(data + i + j * lanes<type>), acc[j]);
+		type lane[width];
+		for (size_t j = 0; j < k; ++j)
+			store(lane + j * lanes<type>, acc[j]);
+		return Scalar::extreme<type, greater>(lane, data + i, n - i);
+	}
+
+	static float sum(const float* data, size_t n) noexcept
+	{
+		constexpr size_t width = Scalar::lanes<float>, k = width / lanes<float>;
+		__m256 acc[k];
+		for (auto& a : acc)
+			a = _mm256_setzero_ps();
+		size_t i = 0;
+		for (; i + width <= n; i += width)
+			for (size_t j = 0; j < k; ++j)
+				acc[j] = _mm256_add_ps(acc[j], load(data + i + j * lanes<float>));
+		float lane[width];
+		for (size_t j = 0; j < k; ++j)
+			store(lane + j * lanes<float>, acc[j]);
+		return Scalar::sum(lane, data + i, n - i);
+	}
+	static int64_t sum(const int32_t* data, size_t n) noexcept
+	{
+		__m256i acc = _mm256_setzero_si256();
+		size_t i = 0;
+		for (; i + lanes<int32_t> <= n; i += lanes<int32_t>)
+		{
+			__m256i x = load(data + i);
+			acc = _mm256_add_epi64(acc, _mm256_add_epi64(
+				_mm256_cvtepi32_epi64(_mm256_castsi256_si128(x)), _mm256_cvtepi32_epi64(_mm256_extracti128_si256(x, 1))));
+		}
+		return int64_t(total(acc) + uint64_t(Scalar::sum(data + i, n - i)));
+	}
+	static uint64_t sum(const uint8_t* data, size_t n) noexcept
+	{
+		__m256i acc = _mm256_setzero_si256(), zero = _mm256_setzero_si256();
+		size_t i = 0;
+		for (; i + lanes<uint8_t> <= n; i += lanes<uint8_t>)
+			acc = _mm256_add_epi64(acc, _mm256_sad_epu8(load(data + i), zero));
+		return total(acc) + Scalar::sum(data + i, n - i);
+	}
+
+	static float dot(const float* a, const float* b, size_t n) noexcept
+	{
+		constexpr size_t width = Scalar::lanes<float>, k = width / lanes<float>;
+		__m256 acc[k];
+		for (auto& r : acc)
+			r = _mm256_setzero_ps();
+		size_t i = 0;
+		for (; i + width <= n; i += width)
+			for (size_t j = 0; j < k; ++j)
+				acc[j] = _mm256_add_ps(acc[j], _mm256_mul_ps(load(a + i + j * lanes<float>), load(b + i + j * lanes<float>)));
+		float lane[width];
+		for (size_t j = 0; j < k; ++j)
+			store(lane + j * lanes<float>, acc[j]);
+		return Scalar::dot(lane, a + i, b + i, n - i);
+	}
+	/// <summary>
+	///	Even and odd lanes are multiplied separately into 64 bit products.
+	/// </summary>
+	static int64_t dot(const int32_t* a, const int32_t* b, size_t n) noexcept
+	{
+		__m256i acc = _mm256_setzero_si256();
+		size_t i = 0;
+		for (; i + lanes<int32_t> <= n; i += lanes<int32_t>)
+		{
+			__m256i x = load(a + i), y = load(b + i);
+			acc = _mm256_add_epi64(acc, _mm256_add_epi64(_mm256_mul_epi32(x, y),
+				_mm256_mul_epi32(_mm256_srli_epi64(x, 32), _mm256_srli_epi64(y, 32))));
+		}
+		return int64_t(total(acc) + uint64_t(Scalar::dot(a + i, b + i, n - i)));
+	}
+	/// <summary>
+	///	Products are summed in 32 bit lanes for 8192 steps (4 * 255 * 255 per step), then widened.
+	/// </summary>
+	static uint64_t dot(const uint8_t* a, const uint8_t* b, size_t n) noexcept
+	{
+		constexpr size_t step = lanes<uint8_t>, limit = step * 8192;
+		__m256i acc = _mm256_setzero_si256(), zero = _mm256_setzero_si256();
+		size_t i = 0;
+		while (n - i >= step)
+		{
+			size_t end = i + ((n - i < limit ? n - i : limit) / step) * step;
+			__m256i part = zero;
+			for (; i < end; i += step)
+			{
+				__m256i x = load(a + i), y = load(b + i);
+				part = _mm256_add_epi32(part, _mm256_add_epi32(
+					_mm256_madd_epi16(_mm256_unpacklo_epi8(x, zero), _mm256_unpacklo_epi8(y, zero)),
+					_mm256_madd_epi16(_mm256_unpackhi_epi8(x, zero), _mm256_unpackhi_epi8(y, zero))));
+			}
+			acc = _mm256_add_epi64(acc, _mm256_add_epi64(_mm256_unpacklo_epi32(part, zero), _mm256_unpackhi_epi32(part, zero)));
+		}
+		return total(acc) + Scalar::dot(a + i, b + i, n - i);
+	}
+};
+
+ULTIMAAPI_TARGET_POP
+
+ULTIMAAPI_TARGET_PUSH("avx512f,avx512bw")
+#if defined(__GNUC__) && !defined(__clang__)
+#	pragma GCC diagnostic push
+#	pragma GCC diagnostic ignored "-Wmaybe-uninitialized"	// _mm512_undefined_* of the intrinsic headers
+#endif
+
+/// <summary>
+///	64 byte kernels, one register holds all the lanes of Scalar.
+/// </summary>
+struct UltimaAPI::Kernel::Avx512
+{
+	template <typename type, typename = void>
+	struct	vec { using reg = __m512i; };
+	template <typename unused>
+	struct	vec<float, unused> { using reg = __m512; };
+
+	template <typename type>
+	using reg = typename vec<type>::reg;
+	template <typename type>
+	static constexpr size_t lanes = sizeof(reg<type>) / sizeof(type);
+
+	template <typename type>
+	__forceinline static reg<type> load(const type* p) noexcept
+	{
+		if constexpr (std::is_same<type, float>::value)
+			return _mm512_loadu_ps(p);
+		else return _mm512_loadu_si512(p);
+	}
+	template <typename type>
+	__forceinline static void store(type* p, reg<type> r) noexcept
+	{
+		if constexpr (std::is_same<type, float>::value)
+			_mm512_storeu_ps(p, r);
+		else _mm512_storeu_si512(p, r);
+	}
+	template <typename type>
+	__forceinline static reg<type> splat(type value) noexcept
+	{
+		if constexpr (std::is_same<type, float>::value)
+			return _mm512_set1_ps(value);
+		else if constexpr (sizeof(type) == 4)
+			return _mm512_set1_epi32(value);
+		else return _mm512_set1_epi8(char(value));
+	}
+	/// <summary>
+	///	Bit per lane where a == b.
+	/// </summary>
+	template <typename type>
+	__forceinline static uint64_t equal(reg<type> a, reg<type> b) noexcept
+	{
+		if constexpr (std::is_same<type, float>::value)
+			return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ);
+		else if constexpr (sizeof(type) == 4)
+			return _mm512_cmpeq_epi32_mask(a, b);
+		else return _mm512_cmpeq_epi8_mask(a, b);
+	}
+	template <typename type, bool greater>
+	__forceinline static reg<type> pick(reg<type> x, reg<type> m) noexcept
+	{
+		if constexpr (std::is_same<type, float>::value)
+			return greater ? _mm512_max_ps(x, m) : _mm512_min_ps(x, m);
+		else if constexpr (sizeof(type) == 4)
+			return greater ? _mm512_max_epi32(x, m) : _mm512_min_epi32(x, m);
+		else return greater ? _mm512_max_epu8(x, m) : _mm512_min_epu8(x, m);
+	}
+	__forceinline static uint64_t total(__m512i acc) noexcept
+	{
+		uint64_t t[8];
+		store(t, acc);
+		return t[0] + t[1] + t[2] + t[3] + t[4] + t[5] + t[6] + t[7];
+	}
+
+	template <typename type>
+	static size_t find(const type* data, size_t n, type value) noexcept
+	{
+		reg<type> v = splat(value);
+		size_t i = 0;
+		for (; i + lanes<type> <= n; i += lanes<type>)
+			if (uint64_t hit = equal<type>(load(data + i), v))
+				return i + Scalar::ctz(hit);
+		return i + Scalar::find(data + i, n - i, value);
+	}
+	template <typename type>
+	static size_t count(const type* data, size_t n, type value) noexcept
+	{
+		reg<type> v = splat(value);
+		size_t c = 0, i = 0;
+		for (; i + lanes<type> <= n; i += lanes<type>)
+			c += Scalar::popcount(equal<type>(load(data + i), v));
+		return c + Scalar::count(data + i, n - i, value);
+	}
+	template <typename type, bool greater>
+	static type extreme(const type* data, size_t n) noexcept
+	{
+		reg<type> acc = splat(Scalar::identity<type, greater>());
+		size_t i = 0;
+		for (; i + lanes<type> <= n; i += lanes<type>)
+			acc = pick<type, greater>(load(data + i), acc);
+		type lane[lanes<type>];
+		store(lane, acc);
+		return Scalar::extreme<type, greater>(lane, data + i, n - i);
+	}
+
+	static float sum(const float* data, size_t n) noexcept
+	{
+		__m512 acc = _mm512_setzero_ps();
+		size_t i = 0;
+		for (; i + lanes<float> <= n; i += lanes<float>)
+			acc = _mm512_add_ps(acc, load(data + i));
+		float lane[lanes<float>];
+		store(lane, acc);
+		return Scalar::sum(lane, data + i, n - i);
+	}
+	static int64_t sum(const int32_t* data, size_t n) noexcept
+	{
+		__m512i acc = _mm512_setzero_si512();
+		size_t i = 0;
+		for (; i + lanes<int32_t> <= n; i += lanes<int32_t>)
+		{
+			__m512i x = load(data + i);
+			acc = _mm512_add_epi64(acc, _mm512_add_epi64(
+				_mm512_cvtepi32_epi64(_mm512_castsi512_si256(x)), _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(x, 1))));
+		}
+		return int64_t(total(acc) + uint64_t(Scalar::sum(data + i, n - i)));
+	}
+	static uint64_t sum(const uint8_t* data, size_t n) noexcept
+	{
+		__m512i acc = _mm512_setzero_si512(), zero = _mm512_setzero_si512();
+		size_t i = 0;
+		for (; i + lanes<uint8_t> <= n; i += lanes<uint8_t>)
+			acc = _mm512_add_epi64(acc, _mm512_sad_epu8(load(data + i), zero));
+		return total(acc) + Scalar::sum(data + i, n - i);
+	}
+
+	static float dot(const float* a, const float* b, size_t n) noexcept
+	{
+		__m512 acc = _mm512_setzero_ps();
+		size_t i = 0;
+		for (; i + lanes<float> <= n; i += lanes<float>)
+			acc = _mm512_add_ps(acc, _mm512_mul_ps(load(a + i), load(b + i)));
+		float lane[lanes<float>];
+		store(lane, acc);
+		return Scalar::dot(lane, a + i, b + i, n - i);
+	}
+	/// <summary>
+	///	Even and odd lanes are multiplied separately into 64 bit products.
+	/// </summary>
+	static int64_t dot(const int32_t* a, const int32_t* b, size_t n) noexcept
+	{
+		__m512i acc = _mm512_setzero_si512();
+		size_t i = 0;
+		for (; i + lanes<int32_t> <= n; i += lanes<int32_t>)
+		{
+			__m512i x = load(a + i), y = load(b + i);
+			acc = _mm512_add_epi64(acc, _mm512_add_epi64(_mm512_mul_epi32(x, y),
+				_mm512_mul_epi32(_mm512_srli_epi64(x, 32), _mm512_srli_epi64(y, 32))));
+		}
+		return int64_t(total(acc) + uint64_t(Scalar::dot(a + i, b + i, n - i)));
+	}
+	/// <summary>
+	///	Products are summed in 32 bit lanes for 8192 steps (4 * 255 * 255 per step), then widened.
+	/// </summary>
+	static uint64_t dot(const uint8_t* a, const uint8_t* b, size_t n) noexcept
+	{
+		constexpr size_t step = lanes<uint8_t>, limit = step * 8192;
+		__m512i acc = _mm512_setzero_si512(), zero = _mm512_setzero_si512();
+		size_t i = 0;
+		while (n - i >= step)
+		{
+			size_t end = i + ((n - i < limit ? n - i : limit) / step) * step;
+			__m512i part = zero;
+			for (; i < end; i += step)
+			{
+				__m512i x = load(a + i), y = load(b + i);
+				part = _mm512_add_epi32(part, _mm512_add_epi32(
+					_mm512_madd_epi16(_mm512_unpacklo_epi8(x, zero), _mm512_unpacklo_epi8(y, zero)),
+					_mm512_madd_epi16(_mm512_unpackhi_epi8(x, zero), _mm512_unpackhi_epi8(y, zero))));
+			}
+			acc = _mm512_add_epi64(acc, _mm512_add_epi64(_mm512_unpacklo_epi32(part, zero), _mm512_unpackhi_epi32(part, zero)));
+		}
+		return total(acc) + Scalar::dot(a + i, b + i, n - i);
+	}
+};
+
+#if defined(__GNUC__) && !defined(__clang__)
+#	pragma GCC diagnostic pop
+#endif
+ULTIMAAPI_TARGET_POP
+
+#endif
+
+/// <summary>
+///	Search and reduction algorithms over contiguous elements (Vector::data(), size()).
+///	float, int32_t and uint8_t run the SSE2, AVX2 or AVX-512 kernel picked by CPUID on the first call,
+///	other arithmetic types and other processors run Kernel::Scalar.
+///	Every kernel returns the same bits as Kernel::Scalar, see there for the floating point order.
+/// </summary>
+struct UltimaAPI::Simd
+{
+	enum class	Level
+	{
+		Scalar,
+		Sse2,
+		Avx2,
+		Avx512,
+	};
+private:
+	template <typename type>
+	static constexpr bool vectorized = std::is_same<type, float>::value || std::is_same<type, int32_t>::value || std::is_same<type, uint8_t>::value;
+
+	template <typename vector>
+	using element = std::remove_cv_t<std::remove_pointer_t<decltype(std::declval<const vector&>().data())>>;
+
+	static Level detect() noexcept
+	{
+#if defined(ULTIMAAPI_X64)
+#	if defined(_MSC_VER) && !defined(__clang__)
+		int r[4];
+		__cpuid(r, 0);
+		int top = r[0], features = 0;
+		__cpuid(r, 1);
+		unsigned __int64 xcr = r[2] & (1 << 27) ? _xgetbv(0) : 0;
+		if (top >= 7)
+		{
+			__cpuidex(r, 7, 0);
+			features = r[1];
+		}
+		if ((features & (1 << 16)) && (features & (1 << 30)) && (xcr & 0xe6) == 0xe6)
+			return Level::Avx512;
+		if ((features & (1 << 5)) && (xcr & 0x6) == 0x6)
+			return Level::Avx2;
+#	else
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+			return Level::Avx512;
+		if (__builtin_cpu_supports("avx2"))
+			return Level::Avx2;
+#	endif
+		return Level::Sse2;
+#else
+		return Level::Scalar;
+#endif
+	}
+
+	template <typename type, typename call>
+	__forceinline static decltype(auto) dispatch(call&& f) noexcept
+	{
+#if defined(ULTIMAAPI_X64)
+		if constexpr (vectorized<type>)
+			switch (level())
+			{
+			case Level::Avx512:
+				return f(Kernel::Avx512());
+			case Level::Avx2:
+				return f(Kernel::Avx2());
+			case Level::Sse2:
+				return f(Kernel::Sse2());
+			default:
+				break;
+			}
+#endif
+		return f(Kernel::Scalar());
+	}
+public:
+	template <typename type>
+	using accumulator = Kernel::Scalar::accumulator<type>;
+
+	/// <summary>
+	///	Level of the processor, detected on the first call.
+	///	Lower it to run (compare, benchmark) the narrower kernels.
+	/// </summary>
+	static decltype(auto) level() noexcept
+	{
+		static Level l = detect();
+		return (l);
+	}
+
+	/// <summary>
+	///	Index of the first element equal to value, n if there is none.
+	/// </summary>
+	template <typename type>
+	static size_t find(const type* data, size_t n, type value) noexcept
+	{
+		return dispatch<type>([&](auto kernel) { return decltype(kernel)::find(data, n, value); });
+	}
+	template <typename type>
+	static size_t count(const type* data, size_t n, type value) noexcept
+	{
+		return dispatch<type>([&](auto kernel) { return decltype(kernel)::count(data, n, value); });
+	}
+	/// <summary>
+	///	Infinity (the limit of an integer type) for no elements, NaN elements are skipped.
+	/// </summary>
+	template <typename type>
+	static type min(const type* data, size_t n) noexcept
+	{
+		return dispatch<type>([&](auto kernel) { return decltype(kernel)::template extreme<type, false>(data, n); });
+	}
+	template <typename type>
+	static type max(const type* data, size_t n) noexcept
+	{
+		return dispatch<type>([&](auto kernel) { return decltype(kernel)::template extreme<type, true>(data, n); });
+	}
+	/// <summary>
+	///	int64_t / uint64_t for integer types.
+	/// </summary>
+	template <typename type>
+	static accumulator<type> sum(const type* data, size_t n) noexcept
+	{
+		return dispatch<type>([&](auto kernel) { return accumulator<type>(decltype(kernel)::sum(data, n)); });
+	}
+	template <typename type>
+	static accumulator<type> dot(const type* a, const type* b, size_t n) noexcept
+	{
+		return dispatch<type>([&](auto kernel) { return accumulator<type>(decltype(kernel)::dot(a, b, n)); });
+	}
+
+	template <typename vector>
+	static decltype(auto) find(const vector& v, const element<vector>& value) noexcept
+	{
+		return find(v.data(), size_t(v.size()), value);
+	}
+	template <typename vector>
+	static decltype(auto) count(const vector& v, const element<vector>& value) noexcept
+	{
+		return count(v.data(), size_t(v.size()), value);
+	}
+	template <typename vector>
+	static decltype(auto) min(const vector& v) noexcept
+	{
+		return min(v.data(), size_t(v.size()));
+	}
+	template <typename vector>
+	static decltype(auto) max(const vector& v) noexcept
+	{
+		return max(v.data(), size_t(v.size()));
+	}
+	template <typename vector>
+	static decltype(auto) sum(const vector& v) noexcept
+	{
+		return sum(v.data(), size_t(v.size()));
+	}
+	/// <summary>
+	///	Over the length of the shorter vector.
+	/// </summary>
+	template <typename vector>
+	static decltype(auto) dot(const vector& a, const vector& b) noexcept
+	{
+		return dot(a.data(), b.data(), size_t(a.size() < b.size() ? a.size() : b.size()));
+	}
+};
@@ -0,0 +1,350 @@
+#pragma once
+
+#include <memory.h>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "Allocator.h"
+#include "Growth.h"
+#include "Vector.h"
+
+namespace UltimaAPI
+{
+	template <typename allocator, typename growth, typename... fields>  class BasicSoaVector;
+	template <typename... fields>  using SoaVector = BasicSoaVector<Allocator::Heap, Growth::Root, fields...>;
+}
+
+/// <summary>
+///	Structure of arrays: one contiguous column per field, one size and capacity for all of them.
+///	All columns are cut from one block, every column starts on a cache line of the block.
+///	column<i>() is a plain pointer for the loops over one field,
+///	operator[] and the iterators give the row as a tuple of references (for (auto [a, b] : soa)).
+/// </summary>
+template <typename allocator, typename growth, typename... fields>
+class UltimaAPI::BasicSoaVector
+{
+	static_assert(sizeof...(fields) > 0, "SoaVector needs at least one field");
+
+	using columns_type = std::tuple<fields*...>;
+	using sequence = std::index_sequence_for<fields...>;
+
+	static constexpr size_t line = 64;
+
+	void* block = nullptr;
+	columns_type columns{};
+	size_t used = 0, allocated = 0;
+
+	template <typename type>
+	static decltype(auto) construct(type* first, type* last) noexcept
+	{
+		if constexpr (!std::is_trivially_default_constructible<type>::value)
+			for (; first < last; ++first)
+				new (first) type;
+	}
+	template <typename type>
+	static decltype(auto) destroy(type* first, type* last) noexcept
+	{
+		if constexpr (!std::is_trivially_destructible<type>::value)
+			for (; first < last; ++first)
+				first->~type();
+	}
+	template <typename type>
+	static decltype(auto) clone(type* to, const type* from, size_t count) noexcept
+	{
+		if constexpr (std::is_trivially_copyable<type>::value)
+		{
+			if (count)
+				memcpy(static_cast<void*>(to), from, count * sizeof(type));
+		}
+		else
+			for (const type* last = from + count; from < last; ++from, ++to)
+				new (to) type(*from);
+	}
+	template <typename type>
+	static decltype(auto) relocate(type* to, type* from, size_t count) noexcept
+	{
+		if constexpr (is_trivially_relocatable<type>::value)
+		{
+			if (count)
+				memcpy(static_cast<void*>(to), from, count * sizeof(type));
+		}
+		else
+			for (type* last = from + count; from < last; ++from, ++to)
+			{
+				new (to) type(std::move(*from));
+				from->~type();
+			}
+	}
+
+	__forceinline static constexpr size_t round(size_t bytes) noexcept
+	{
+		return (bytes + line - 1) & ~(line - 1);
+	}
+	__forceinline static constexpr size_t bytes(size_t al) noexcept
+	{
+		return (round(al * sizeof(fields)) + ...);
+	}
+	__forceinline static size_t next(size_t al, size_t needed) noexcept
+	{
+		return growth::next(al, needed, (sizeof(fields) + ...));
+	}
+	template <typename type>
+	__forceinline static type* cut(unsigned __int8*& at, size_t al) noexcept
+	{
+		type* column = reinterpret_cast<type*>(at);
+		at += round(al * sizeof(type));
+		return column;
+	}
+
+	/// <summary>
+	///	f(std::integral_constant<size_t, i>) for every column i.
+	/// </summary>
+	template <typename function, size_t... i>
+	__forceinline static decltype(auto) each(function&& f, std::index_sequence<i...>) noexcept
+	{
+		(f(std::integral_constant<size_t, i>()), ...);
+	}
+	template <typename function>
+	__forceinline static decltype(auto) each(function&& f) noexcept
+	{
+		each(f, sequence());
+	}
+
+	/// <summary>
+	///	Moves the columns to a new block of al rows, al >= used.
+	/// </summary>
+	decltype(auto) allocate(size_t al) noexcept
+	{
+		void* next = al ? allocator::allocate(bytes(al)) : nullptr;
+		unsigned __int8* at = static_cast<unsigned __int8*>(next);
+		columns_type to{ cut<fields>(at, al)... };
+		each([&](auto i) { relocate(std::get<i>(to), std::get<i>(columns), used); });
+		if (block)
+			allocator::deallocate(block, bytes(allocated));
+		block = next;
+		columns = to;
+		allocated = al;
+	}
+	template <size_t... i>
+	decltype(auto) row(size_t at, std::index_sequence<i...>) noexcept
+	{
+		return std::tuple<fields&...>(std::get<i>(columns)[at]...);
+	}
+	template <size_t... i>
+	decltype(auto) row(size_t at, std::index_sequence<i...>) const noexcept
+	{
+		return std::tuple<const fields&...>(std::get<i>(columns)[at]...);
+	}
+	template <size_t... i, typename... args>
+	decltype(auto) place(std::index_sequence<i...>, args&&... values) noexcept
+	{
+		(new (std::get<i>(columns) + used) fields(std::forward<args>(values)), ...);
+	}
+
+	template <typename owner, typename reference>
+	class	basic_iterator
+	{
+		owner* v;
+		size_t at;
+	public:
+		decltype(auto) operator*() const noexcept
+		{
+			return reference((*v)[at]);
+		}
+		decltype(auto) operator++() noexcept
+		{
+			++at;
+			return *this;
+		}
+		decltype(auto) operator--() noexcept
+		{
+			--at;
+			return *this;
+		}
+		decltype(auto) operator+=(ptrdiff_t n) noexcept
+		{
+			at += n;
+			return *this;
+		}
+		decltype(auto) operator-(const basic_iterator& it) const noexcept
+		{
+			return ptrdiff_t(at - it.at);
+		}
+		decltype(auto) operator==(const basic_iterator& it) const noexcept
+		{
+			return at == it.at;
+		}
+		decltype(auto) operator!=(const basic_iterator& it) const noexcept
+		{
+			return at != it.at;
+		}
+
+		basic_iterator(owner* vector, size_t index) noexcept : v(vector), at(index) {}
+	};
+public:
+	using iterator = basic_iterator<BasicSoaVector, std::tuple<fields&...>>;
+	using const_iterator = basic_iterator<const BasicSoaVector, std::tuple<const fields&...>>;
+
+	/// <summary>
+	///	Column of the i-th field.
+	/// </summary>
+	template <size_t i>
+	decltype(auto) column() noexcept
+	{
+		return std::get<i>(columns);
+	}
+	template <size_t i>
+	decltype(auto) column() const noexcept
+	{
+		return static_cast<const std::tuple_element_t<i, std::tuple<fields...>>*>(std::get<i>(columns));
+	}
+
+	template <typename... args>
+	decltype(auto) emplace_back(args&&... values) noexcept
+	{
+		static_assert(sizeof...(args) == sizeof...(fields), "one value per field");
+		if (used >= allocated)
+		{
+			std::tuple<fields...> copy(std::forward<args>(values)...);
+			allocate(next(allocated, used + 1));
+			std::apply([this](auto&... v) { place(sequence(), std::move(v)...); }, copy);
+		}
+		else place(sequence(), std::forward<args>(values)...);
+		return (*this)[used++];
+	}
+	decltype(auto) push_back(fields... values) noexcept
+	{
+		emplace_back(std::move(values)...);
+	}
+	decltype(auto) pop_back() noexcept
+	{
+		if (used)
+		{
+			--used;
+			each([&](auto i) { destroy(std::get<i>(columns) + used, std::get<i>(columns) + used + 1); });
+		}
+	}
+
+	decltype(auto) size() const noexcept
+	{
+		return used;
+	}
+	decltype(auto) capacity() const noexcept
+	{
+		return allocated;
+	}
+	decltype(auto) empty() const noexcept
+	{
+		return used == 0;
+	}
+	decltype(auto) clear() noexcept
+	{
+		each([&](auto i) { destroy(std::get<i>(columns), std::get<i>(columns) + used); });
+		used = 0;
+	}
+	decltype(auto) resize(size_t sz) noexcept
+	{
+		if (sz > allocated)
+			allocate(sz);
+		if (sz > used)
+			each([&](auto i) { construct(std::get<i>(columns) + used, std::get<i>(columns) + sz); });
+		else each([&](auto i) { destroy(std::get<i>(columns) + sz, std::get<i>(columns) + used); });
+		used = sz;
+	}
+	decltype(auto) reserve(size_t sz) noexcept
+	{
+		if (sz > allocated)
+			allocate(sz);
+	}
+	decltype(auto) shrink_to_fit() noexcept
+	{
+		if (used < allocated)
+			allocate(used);
+	}
+	decltype(auto) free() noexcept
+	{
+		clear();
+		allocate(0);
+	}
+
+	decltype(auto) operator[](size_t i) noexcept
+	{
+		return row(i, sequence());
+	}
+	decltype(auto) operator[](size_t i) const noexcept
+	{
+		return row(i, sequence());
+	}
+
+	decltype(auto) begin() noexcept
+	{
+		return iterator(this, 0);
+	}
+	decltype(auto) end() noexcept
+	{
+		return iterator(this, used);
+	}
+	decltype(auto) begin() const noexcept
+	{
+		return const_iterator(this, 0);
+	}
+	decltype(auto) end() const noexcept
+	{
+		return const_iterator(this, used);
+	}
+	decltype(auto) cbegin() const noexcept
+	{
+		return const_iterator(this, 0);
+	}
+	decltype(auto) cend() const noexcept
+	{
+		return const_iterator(this, used);
+	}
+
+	BasicSoaVector& operator=(const BasicSoaVector& v) noexcept
+	{
+		if (&v != this)
+		{
+			clear();
+			reserve(v.used);
+			each([&](auto i) { clone(std::get<i>(columns), std::get<i>(v.columns), v.used); });
+			used = v.used;
+		}
+		return *this;
+	}
+	BasicSoaVector& operator=(BasicSoaVector&& v) noexcept
+	{
+		if (&v != this)
+		{
+			free();
+			block = v.block;
+			columns = v.columns;
+			used = v.used;
+			allocated = v.allocated;
+			v.block = nullptr;
+			v.columns = columns_type();
+			v.used = v.allocated = 0;
+		}
+		return *this;
+	}
+
+	BasicSoaVector() noexcept = default;
+	BasicSoaVector(size_t sz) noexcept
+	{
+		reserve(sz);
+	}
+	BasicSoaVector(const BasicSoaVector& v) noexcept
+	{
+		*this = v;
+	}
+	BasicSoaVector(BasicSoaVector&& v) noexcept
+	{
+		*this = std::move(v);
+	}
+	~BasicSoaVector() noexcept
+	{
+		free();
+	}
+};
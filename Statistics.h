@@ -0,0 +1,164 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <initializer_list>
+#include <typeinfo>
+
+#include "Compiler.h"
+
+namespace UltimaAPI
+{
+	template <typename type>	struct statistics_tag;
+	class	Statistics;
+}
+
+/// <summary>
+///	Key of the statistics of the vectors of type, the element type itself.
+///	Specialize it to count several element types under one user tag:
+///	template <> struct UltimaAPI::statistics_tag<Order> { using tag = Trading; };
+/// </summary>
+template <typename type>
+struct UltimaAPI::statistics_tag
+{
+	using tag = type;
+};
+
+/// <summary>
+///	Allocation and growth counters of the Vector, per statistics_tag.
+///	Compiled in only with ULTIMAAPI_STATISTICS defined, otherwise the hooks are empty
+///	and nothing is registered (each() finds no tags, get() is zero).
+///	The counters are relaxed atomics, the vectors of one tag can live on many threads.
+/// </summary>
+class UltimaAPI::Statistics
+{
+public:
+#if defined(ULTIMAAPI_STATISTICS)
+	static constexpr bool enabled = true;
+#else
+	static constexpr bool enabled = false;
+#endif
+
+	struct	snapshot
+	{
+		const char* name;		// typeid(tag).name(), nullptr without ULTIMAAPI_STATISTICS
+		uint64_t allocations;		// blocks taken from the allocator (realloc included)
+		uint64_t frees;			// blocks given back (realloc included)
+		uint64_t relocated_bytes;	// bytes moved to a new block by the growth and the shrink
+		uint64_t to_heap;		// inline container -> heap block
+		uint64_t to_inline;		// heap block -> inline container
+		uint64_t peak_bytes;		// largest block
+	};
+private:
+	struct	counters;
+
+	/// <summary>
+	///	Registered counters of all tags.
+	/// </summary>
+	static decltype(auto) head() noexcept
+	{
+		static std::atomic<counters*> list{ nullptr };
+		return (list);
+	}
+
+	struct	counters
+	{
+		std::atomic<uint64_t> allocations{ 0 }, frees{ 0 }, relocated_bytes{ 0 }, to_heap{ 0 }, to_inline{ 0 }, peak_bytes{ 0 };
+		const char* name;
+		counters* next;
+
+		counters(const char* tag) noexcept : name(tag), next(head().load(std::memory_order_relaxed))
+		{
+			while (!head().compare_exchange_weak(next, this, std::memory_order_release, std::memory_order_relaxed));
+		}
+	};
+	template <typename tag>
+	static decltype(auto) of() noexcept
+	{
+		static counters c(typeid(tag).name());
+		return (c);
+	}
+	static decltype(auto) read(const counters& c) noexcept
+	{
+		return snapshot
+		{
+			c.name,
+			c.allocations.load(std::memory_order_relaxed),
+			c.frees.load(std::memory_order_relaxed),
+			c.relocated_bytes.load(std::memory_order_relaxed),
+			c.to_heap.load(std::memory_order_relaxed),
+			c.to_inline.load(std::memory_order_relaxed),
+			c.peak_bytes.load(std::memory_order_relaxed),
+		};
+	}
+public:
+	/// <summary>
+	///	Hooks of the Vector.
+	/// </summary>
+	template <typename tag>
+	__forceinline static decltype(auto) allocation(size_t bytes) noexcept
+	{
+		if constexpr (enabled)
+		{
+			counters& c = of<tag>();
+			c.allocations.fetch_add(1, std::memory_order_relaxed);
+			uint64_t peak = c.peak_bytes.load(std::memory_order_relaxed);
+			while (peak < bytes && !c.peak_bytes.compare_exchange_weak(peak, bytes, std::memory_order_relaxed));
+		}
+	}
+	template <typename tag>
+	__forceinline static decltype(auto) deallocation() noexcept
+	{
+		if constexpr (enabled)
+			of<tag>().frees.fetch_add(1, std::memory_order_relaxed);
+	}
+	template <typename tag>
+	__forceinline static decltype(auto) relocation(size_t bytes) noexcept
+	{
+		if constexpr (enabled)
+			of<tag>().relocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+	}
+	template <typename tag>
+	__forceinline static decltype(auto) spill() noexcept
+	{
+		if constexpr (enabled)
+			of<tag>().to_heap.fetch_add(1, std::memory_order_relaxed);
+	}
+	template <typename tag>
+	__forceinline static decltype(auto) unspill() noexcept
+	{
+		if constexpr (enabled)
+			of<tag>().to_inline.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/// <summary>
+	///	Counters of one tag.
+	/// </summary>
+	template <typename tag>
+	static decltype(auto) get() noexcept
+	{
+		if constexpr (enabled)
+			return read(of<tag>());
+		else return snapshot{ nullptr, 0, 0, 0, 0, 0, 0 };
+	}
+	/// <summary>
+	///	f(const snapshot&) for every tag counted so far.
+	/// </summary>
+	template <typename function>
+	static decltype(auto) each(function&& f)
+	{
+		for (counters* c = head().load(std::memory_order_acquire); c; c = c->next)
+			f(read(*c));
+	}
+	template <typename tag>
+	static decltype(auto) reset() noexcept
+	{
+		if constexpr (enabled)
+		{
+			counters& c = of<tag>();
+			for (auto* v : { &c.allocations, &c.frees, &c.relocated_bytes, &c.to_heap, &c.to_inline, &c.peak_bytes })
+				v->store(0, std::memory_order_relaxed);
+		}
+	}
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Compiler.h"
+
+#if !defined(ULTIMAAPI_NO_TRACE) && defined(__has_include)
+#	if __has_include(<sys/sdt.h>)
+#		include <sys/sdt.h>
+#		define ULTIMAAPI_TRACE_ENABLED
+#	endif
+#endif
+
+/// <summary>
+///	USDT probe ultimaapi:probe with the old and the new capacity (elements), the bytes copied and sizeof the element.
+///	With <sys/sdt.h> (systemtap-sdt-dev) a probe is one nop and a note in .note.stapsdt,
+///	it costs nothing until perf or bpftrace attaches to it. Without it (or with ULTIMAAPI_NO_TRACE) it is nothing.
+///	Probes of the Vector:
+///	begin		- before every allocation / deallocation below, (old, new, bytes used, sizeof)
+///	allocate	- first heap block
+///	reallocate	- heap block replaced (or extended in place, then 0 bytes copied)
+///	spill		- inline container -> heap block
+///	unspill		- heap block -> inline container
+///	free		- heap block given back
+///	Trace/*.bt are bpftrace scripts over them.
+/// </summary>
+#if defined(ULTIMAAPI_TRACE_ENABLED)
+#	define ULTIMAAPI_TRACE(probe, old_capacity, new_capacity, bytes, element)	\
+		DTRACE_PROBE4(ultimaapi, probe, size_t(old_capacity), size_t(new_capacity), size_t(bytes), size_t(element))
+#else
+#	define ULTIMAAPI_TRACE(probe, old_capacity, new_capacity, bytes, element)	((void)0)
+#endif
@@ -1,78 +1,356 @@
 #pragma once
 
 #include <memory.h>
+#include <memory>
+#include <new>
+#include <utility>
+#include <iterator>
 #include <initializer_list>
+#include <stdexcept>
 
 #include "../BasicIterator/BasicIterator.h"
+#include "Allocator.h"
+#include "Growth.h"
+#include "Statistics.h"
+#include "Trace.h"
 
 namespace UltimaAPI
 {
-	template <typename type>  class Vector;
+	template <typename type>	struct is_trivially_relocatable;
+	template <size_t bytes, size_t align>	struct Container;
+
+	/// <summary>
+	///	Default inline capacity: the elements fitting in the 31 byte inline container of the Vector before
+	///	(Vector<char> 31, Vector<int> 7, Vector<double> 3).
+	/// </summary>
+	template <typename type>
+	constexpr size_t inline_elements = 31 / sizeof(type);
+	/// <summary>
+	///	Inline capacity of one pointer beside the 16/24 byte header, the smallest Vector with inline elements
+	///	(Vector<char> 32 bytes, Vector<int> 24, Vector<double> 24, larger elements 16).
+	/// </summary>
+	template <typename type>
+	constexpr size_t compact_elements = sizeof(void*) / sizeof(type);
+
+	template <typename type, typename allocator = Allocator::Heap, size_t elements = inline_elements<type>, typename growth = Growth::Root>  class Vector;
+
+	/// <summary>
+	///	Vector keeping up to elements in the object itself, without touching the heap.
+	/// </summary>
+	template <typename type, size_t elements, typename allocator = Allocator::Heap, typename growth = Growth::Root>
+	using SmallVector = Vector<type, allocator, elements, growth>;
+	/// <summary>
+	///	Vector of compact_elements, for the vectors kept by the million where the object size counts.
+	/// </summary>
+	template <typename type, typename allocator = Allocator::Heap, typename growth = Growth::Root>
+	using CompactVector = Vector<type, allocator, compact_elements<type>, growth>;
 }
 
+/// <summary>
+///	The object can be moved to another address by memcpy without calling the move constructor and destructor.
+///	Specialize it for own handle types to keep them on the memcpy/realloc path of the Vector.
+/// </summary>
+template <typename type>
+struct UltimaAPI::is_trivially_relocatable : std::is_trivially_copyable<type> {};
 template <typename type>
-class UltimaAPI::Vector
+struct UltimaAPI::is_trivially_relocatable<std::unique_ptr<type>> : std::true_type {};
+/// <summary>
+///	Heap-only vectors hold no pointer into themselves, the vectors of them grow by memcpy/realloc.
+/// </summary>
+template <typename type, typename allocator, typename growth>
+struct UltimaAPI::is_trivially_relocatable<UltimaAPI::Vector<type, allocator, 0, growth>> : std::true_type {};
+
+/// <summary>
+///	Inline buffer of the Vector, empty for the heap-only vectors.
+///	It has the alignment of the allocation policy (Aligned, Huge), so the inline elements are aligned like the heap ones.
+/// </summary>
+template <size_t bytes, size_t align>
+struct UltimaAPI::Container
 {
-	double mul_alloc = 1.6487; // sqrt(e)
-	
-	__forceinline static constexpr const size_t	max_bytes()
-	{
-		return sizeof(pointer) - sizeof(container::use);
-	}
+	alignas(align) unsigned __int8 container[bytes];
+};
+template <size_t align>
+struct UltimaAPI::Container<0, align> {};
 
-	enum	config : __int8
-	{
-		bits_clear = 0,
+template <typename type, typename allocator, size_t elements, typename growth>
+class UltimaAPI::Vector : Container<elements * sizeof(type), Allocator::Traits<allocator>::alignment(alignof(type))>
+{
+	using container_type = Container<elements * sizeof(type), Allocator::Traits<allocator>::alignment(alignof(type))>;
 
-		bit_init	= 1 << 0,
-		bit_always_using_pointer = 1 << 1,
+	/// <summary>
+	///	Large element types keep 4G elements in 32 bit counters (16 byte header),
+	///	small ones need the full size_t (24 byte header).
+	/// </summary>
+	using size_type = std::conditional_t<(sizeof(type) < 4 && sizeof(void*) >= 8), size_t, unsigned __int32>;
 
-		bit_pointer	= 1 << 4,
-		bit_needed_swap = 1 << 5,
-	};
+	/// <summary>
+	///	start points to the inline container while the elements fit there, and to the heap block after the spill,
+	///	so the element access never asks which of them is used.
+	/// </summary>
 	struct	pointer
 	{
-		size_t used;
-		size_t allocated;
-		void* start, *last;
-	};
-	struct	container
-	{
-		__forceinline decltype(auto)	used()	{ return use; }
-		__forceinline decltype(auto)	start()	{ return reinterpret_cast<type*>(&container); }
-		__forceinline decltype(auto)	last()	{ return reinterpret_cast<type*>(&container) + use; }
+		type* start;
+		size_type used;
+		size_type allocated;
+	} p;
 
-		decltype(auto)	right()
-		{ 
-			if (use > 0)
-				return reinterpret_cast<type*>(&container) + use - 1;
-			else return reinterpret_cast<type*>(&container);
-		}
-
-		unsigned __int8	use;
-		unsigned __int8	container[max_bytes()];
-	};
-	union 
-	{
-		pointer p;
-		container c;
-	};
-	__int8 cfg;
+	using traits = Allocator::Traits<allocator>;
+	using statistics_key = typename statistics_tag<type>::tag;
 public:
 	using iterator = BasicIterator<type>;
 	using const_iterator = BasicIterator<const type>;
 	using reverse_iterator = std::reverse_iterator<iterator>;
 	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 private:
-	static_assert(!(sizeof(Vector::pointer) - sizeof(Vector::container)), L"Unequal memory structure used");
+	__forceinline static constexpr size_t	max_elements()
+	{
+		return elements;
+	}
+	__forceinline static constexpr bool	heap_only()
+	{
+		return !max_elements();
+	}
+
+	__forceinline decltype(auto) container() noexcept
+	{
+		if constexpr (heap_only())
+			return static_cast<type*>(nullptr);
+		else return reinterpret_cast<type*>(this->container_type::container);
+	}
+	__forceinline decltype(auto) heap() noexcept
+	{
+		if constexpr (heap_only())
+			return true;
+		else return p.start != container();
+	}
+	/// <summary>
+	///	The heap block is shared with copies (Allocator::Shared).
+	/// </summary>
+	__forceinline decltype(auto) shared() noexcept
+	{
+		if constexpr (traits::shared)
+			return heap() && p.start && !traits::unique(p.start);
+		else return false;
+	}
+	/// <summary>
+	///	Copy on write: a shared block is replaced by an own copy before any change.
+	/// </summary>
+	__forceinline decltype(auto) detach() noexcept
+	{
+		if constexpr (traits::shared)
+			if (shared())
+				unshare();
+	}
+	decltype(auto) unshare() noexcept
+	{
+		ULTIMAAPI_TRACE(begin, p.allocated, p.allocated, p.used * sizeof(type), sizeof(type));
+		type* block = static_cast<type*>(allocator::allocate(p.allocated * sizeof(type)));
+		clone(block, p.start, p.used);
+		Statistics::allocation<statistics_key>(p.allocated * sizeof(type));
+		Statistics::relocation<statistics_key>(p.used * sizeof(type));
+		ULTIMAAPI_TRACE(reallocate, p.allocated, p.allocated, p.used * sizeof(type), sizeof(type));
+		// the block can have become unique meanwhile, free() ends it then with the hooks of every free
+		decltype(p) own = { block, p.used, p.allocated };
+		free();
+		p = own;
+	}
+	/// <summary>
+	///	Takes the elements of v into this empty vector: the heap block is stolen,
+	///	inline elements are relocated (at most max_elements()). v is left empty.
+	/// </summary>
+	decltype(auto) take(Vector& v) noexcept
+	{
+		if (v.heap())
+			p = v.p;
+		else
+		{
+			relocate(container(), v.p.start, v.p.used);
+			p.used = v.p.used;
+		}
+		v.p.start = v.container();
+		v.p.used = 0;
+		v.p.allocated = size_type(max_elements());
+	}
+
+	/// <summary>
+	///	Forward iterators, the range can be walked twice (std::distance, then the copy).
+	/// </summary>
+	template <typename it>
+	using forward = std::enable_if_t<std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<it>::iterator_category>::value>;
+	/// <summary>
+	///	Iterators over contiguous elements of type, their ranges take the pointer overloads (memcpy for the trivial types).
+	/// </summary>
+	template <typename it>
+	__forceinline static constexpr bool contiguous() noexcept
+	{
+		return std::is_same<it, type*>::value || std::is_same<it, const type*>::value ||
+			std::is_same<it, iterator>::value || std::is_same<it, const_iterator>::value;
+	}
+	/// <summary>
+	///	Some element of the range lies in this vector (only the ranges of lvalues of type can).
+	/// </summary>
+	template <typename it>
+	decltype(auto) inside(it first, it last) noexcept
+	{
+		using reference = typename std::iterator_traits<it>::reference;
+		if constexpr (std::is_lvalue_reference<reference>::value && std::is_same<std::remove_cv_t<std::remove_reference_t<reference>>, type>::value)
+			for (; first != last; ++first)
+				if (std::addressof(*first) >= p.start && std::addressof(*first) < p.start + p.used)
+					return true;
+		return false;
+	}
+
+	static decltype(auto) construct(type* first, type* last) noexcept
+	{
+		if constexpr (!std::is_trivially_default_constructible<type>::value)
+			for (; first < last; ++first)
+				new (first) type;
+	}
+	static decltype(auto) destroy(type* first, type* last) noexcept
+	{
+		if constexpr (!std::is_trivially_destructible<type>::value)
+			for (; first < last; ++first)
+				first->~type();
+	}
+	static decltype(auto) clone(type* to, const type* from, size_t count) noexcept
+	{
+		if constexpr (std::is_trivially_copyable<type>::value)
+		{
+			if (count)
+				memcpy(to, from, count * sizeof(type));
+		}
+		else
+			for (const type* last = from + count; from < last; ++from, ++to)
+				new (to) type(*from);
+	}
+	template <typename it>
+	static decltype(auto) clone(type* to, it first, it last) noexcept
+	{
+		for (; first != last; ++first, ++to)
+			new (to) type(*first);
+	}
+	static decltype(auto) fill(type* to, size_t count, const type& val) noexcept
+	{
+		for (type* last = to + count; to < last; ++to)
+			new (to) type(val);
+	}
+	/// <summary>
+	///	Moves count objects to the uninitialized memory, the old objects are ended.
+	/// </summary>
+	static decltype(auto) relocate(type* to, type* from, size_t count) noexcept
+	{
+		if constexpr (is_trivially_relocatable<type>::value)
+		{
+			if (count)
+				memcpy(static_cast<void*>(to), from, count * sizeof(type));
+		}
+		else
+			for (type* last = from + count; from < last; ++from, ++to)
+			{
+				new (to) type(std::move(*from));
+				from->~type();
+			}
+	}
+	/// <summary>
+	///	relocate() for the overlapping ranges.
+	/// </summary>
+	static decltype(auto) shift(type* to, type* from, size_t count) noexcept
+	{
+		if constexpr (is_trivially_relocatable<type>::value)
+		{
+			if (count)
+				memmove(static_cast<void*>(to), from, count * sizeof(type));
+		}
+		else if (to < from)
+			for (type* last = from + count; from < last; ++from, ++to)
+			{
+				new (to) type(std::move(*from));
+				from->~type();
+			}
+		else
+			for (type* first = from; count--;)
+			{
+				new (to + count) type(std::move(first[count]));
+				first[count].~type();
+			}
+	}
+	/// <summary>
+	///	Opens count uninitialized elements at place and returns them.
+	///	The tail is moved once, a new block is built in one pass: prefix, gap, suffix.
+	/// </summary>
+	decltype(auto) gap(size_t place, size_t count) noexcept
+	{
+		detach();
+		if (place > p.used)
+		{
+			if constexpr (std::is_default_constructible<type>::value)
+			{
+				if (place + count > p.allocated)
+					allocate(next(p.allocated, place + count));
+				construct(p.start + p.used, p.start + place);
+				p.used = size_type(place);
+			}
+			else place = p.used;
+		}
 
-	__forceinline static constexpr const size_t	max_elements()
+		size_t tail = p.used - place;
+		if (p.used + count > p.allocated)
+		{
+			size_t al = next(p.allocated, p.used + count);
+			ULTIMAAPI_TRACE(begin, p.allocated, al, p.used * sizeof(type), sizeof(type));
+			type* block = static_cast<type*>(allocator::allocate(al * sizeof(type)));
+			Statistics::allocation<statistics_key>(al * sizeof(type));
+			relocate(block, p.start, place);
+			relocate(block + place + count, p.start + place, tail);
+			Statistics::relocation<statistics_key>((place + tail) * sizeof(type));
+			if (heap() && p.start)
+			{
+				allocator::deallocate(p.start, p.allocated * sizeof(type));
+				Statistics::deallocation<statistics_key>();
+				ULTIMAAPI_TRACE(reallocate, p.allocated, al, (place + tail) * sizeof(type), sizeof(type));
+			}
+			else if constexpr (!heap_only())
+			{
+				Statistics::spill<statistics_key>();
+				ULTIMAAPI_TRACE(spill, p.allocated, al, (place + tail) * sizeof(type), sizeof(type));
+			}
+			else ULTIMAAPI_TRACE(allocate, 0, al, 0, sizeof(type));
+			p.start = block;
+			p.allocated = size_type(traits::usable(block, al * sizeof(type)) / sizeof(type));
+		}
+		else if (tail && count)
+			shift(p.start + place + count, p.start + place, tail);
+		p.used += size_type(count);
+		return p.start + place;
+	}
+	__forceinline decltype(auto) used(size_t sz) noexcept
 	{
-		return max_bytes() / sizeof(type);
+		p.used = size_type(sz);
+	}
+
+	/// <summary>
+	///	More than max_size() elements would be cut by the size_type counters.
+	/// </summary>
+	[[noreturn]] static void overflow()
+	{
+		throw std::length_error("Vector: more than max_size() elements");
+	}
+	/// <summary>
+	///	The growth stops at max_size().
+	/// </summary>
+	__forceinline static size_t next(size_t allocated, size_t needed) noexcept
+	{
+		if (needed > max_size())
+			overflow();
+		size_t al = growth::next(allocated, needed, sizeof(type));
+		return al > max_size() ? max_size() : al;
 	}
 
 	decltype(auto) allocate(size_t al) noexcept
 	{
+		if (al > max_size())
+			overflow();
+		detach();
 		if (al)
 		{
 			if (swaped(al))
@@ -83,14 +361,26 @@ private:
 
 	decltype(auto) swaped(size_t al)
 	{
-		if (cfg & config::bit_pointer)
+		if constexpr (heap_only())
+			return true;
+		else if (heap())
 		{
-			if (max_elements() >= al && p.start)
+			if (max_elements() >= al)
 			{
-				void* block;
-				memcpy(c.start(), block = p.start, (c.use = p.used > al ? al : p.used) * sizeof(type));
-				delete[] block;
-				cfg &= ~config::bit_pointer;
+				type* block = p.start;
+				size_t used = p.used, allocated = p.allocated;
+				ULTIMAAPI_TRACE(begin, allocated, max_elements(), used * sizeof(type), sizeof(type));
+				if (used > al)
+					destroy(block + al, block + used), used = al;
+				relocate(container(), block, used);
+				allocator::deallocate(block, allocated * sizeof(type));
+				Statistics::relocation<statistics_key>(used * sizeof(type));
+				Statistics::deallocation<statistics_key>();
+				Statistics::unspill<statistics_key>();
+				ULTIMAAPI_TRACE(unspill, allocated, max_elements(), used * sizeof(type), sizeof(type));
+				p.start = container();
+				p.used = size_type(used);
+				p.allocated = size_type(max_elements());
 				return false;
 			}
 			else return true;
@@ -99,209 +389,363 @@ private:
 		{
 			if (max_elements() < al)
 			{
-				void* block;
-				p.start = memcpy(block = new type[p.allocated = al], c.start(), c.use * sizeof(type));
-				reinterpret_cast<type*&>(p.last) = reinterpret_cast<type*>(p.start) + (p.used = c.use);
-				cfg |= config::bit_pointer;
-				return false;
+				ULTIMAAPI_TRACE(begin, p.allocated, al, p.used * sizeof(type), sizeof(type));
+				type* block = static_cast<type*>(allocator::allocate(al * sizeof(type)));
+				relocate(block, p.start, p.used);
+				Statistics::allocation<statistics_key>(al * sizeof(type));
+				Statistics::relocation<statistics_key>(p.used * sizeof(type));
+				Statistics::spill<statistics_key>();
+				ULTIMAAPI_TRACE(spill, p.allocated, al, p.used * sizeof(type), sizeof(type));
+				p.start = block;
+				p.allocated = size_type(traits::usable(block, al * sizeof(type)) / sizeof(type));
 			}
-			else return true;
+			else if (p.used > al)
+			{
+				destroy(p.start + al, p.start + p.used);
+				p.used = size_type(al);
+			}
+			return false;
 		}
 	}
 	decltype(auto) pointer(size_t al)
 	{
 		if (!p.start)
 		{
-			p.last = p.start = new type[p.allocated = al];
+			ULTIMAAPI_TRACE(begin, 0, al, 0, sizeof(type));
+			p.start = static_cast<type*>(allocator::allocate(al * sizeof(type)));
+			Statistics::allocation<statistics_key>(al * sizeof(type));
+			ULTIMAAPI_TRACE(allocate, 0, al, 0, sizeof(type));
+			p.used = 0;
+			p.allocated = size_type(traits::usable(p.start, al * sizeof(type)) / sizeof(type));
 		}
 		else if (al == p.allocated); // maybe adding code to do something!
 		else
 		{
-			void* block;
-			memcpy(block = new type[p.allocated = al], p.start, (p.used = p.used > al ? al : p.used) * sizeof(type));
-			delete[] p.start;
-			reinterpret_cast<type*&>(p.last) = reinterpret_cast<type*>(p.start = block) + p.used;
+			type* block = p.start;
+			ULTIMAAPI_TRACE(begin, p.allocated, al, p.used * sizeof(type), sizeof(type));
+			if (p.used > al)
+				destroy(block + al, block + p.used), p.used = size_type(al);
+
+			if constexpr (is_trivially_relocatable<type>::value)
+			{
+				block = static_cast<type*>(traits::reallocate(block, p.allocated * sizeof(type), al * sizeof(type), p.used * sizeof(type)));
+				if (block != p.start)
+					Statistics::relocation<statistics_key>(p.used * sizeof(type));
+			}
+			else
+			{
+				block = static_cast<type*>(allocator::allocate(al * sizeof(type)));
+				relocate(block, p.start, p.used);
+				allocator::deallocate(p.start, p.allocated * sizeof(type));
+				Statistics::relocation<statistics_key>(p.used * sizeof(type));
+			}
+			Statistics::allocation<statistics_key>(al * sizeof(type));
+			Statistics::deallocation<statistics_key>();
+			ULTIMAAPI_TRACE(reallocate, p.allocated, al, block != p.start ? p.used * sizeof(type) : 0, sizeof(type));
+			p.allocated = size_type(traits::usable(p.start = block, al * sizeof(type)) / sizeof(type));
 		}
-		cfg |= config::bit_pointer;
 	}
 public:
-	decltype(auto) push_back(type val) noexcept
-	{
-		if (cfg & config::bit_pointer)
-		{  
-			if (p.used >= p.allocated)
-				allocate(p.allocated * mul_alloc + 1);
-		}
-		else if (c.use >= max_elements())
-			allocate(c.use * mul_alloc + 1);
-
-		if (cfg & config::bit_pointer)
+	/// <summary>
+	///	Constructs the element in place at the end and returns it.
+	///	On the growth the element is built before the block moves, so args can refer to the vector itself.
+	/// </summary>
+	template <typename... Args>
+	decltype(auto) emplace_back(Args&&... args) noexcept
+	{
+		detach();
+		if (p.used >= p.allocated)
 		{
-			if (p.used > 0)
-				++reinterpret_cast<type*&>(p.last);
-			*reinterpret_cast<type*>(p.last) = val;
-			++p.used;
-		}
-		else
-		{
-			*reinterpret_cast<type*>(c.last()) = val;
-			++c.use;
+			type val(std::forward<Args>(args)...);
+			allocate(next(p.allocated, p.used + 1));
+			return *new (p.start + p.used++) type(std::move(val));
 		}
+		return *new (p.start + p.used++) type(std::forward<Args>(args)...);
+	}
+	/// <summary>
+	///	Constructs the element in place before place and returns it.
+	/// </summary>
+	template <typename... Args>
+	decltype(auto) emplace(size_t place, Args&&... args) noexcept
+	{
+		if (place == p.used)
+			return emplace_back(std::forward<Args>(args)...);
+
+		type val(std::forward<Args>(args)...);
+		return *new (gap(place, 1)) type(std::move(val));
+	}
+	decltype(auto) push_back(type val) noexcept
+	{
+		emplace_back(std::move(val));
 	}
 	decltype(auto) pop_back() noexcept
 	{
-		if (cfg & config::bit_pointer)
+		detach();
+		if (p.used > 0)
+			p.start[--p.used].~type();
+	}
+	/// <summary>
+	///	Inserting an element before place, the tail is moved once.
+	///	Place behind the end fills the gap with default elements (appends, if there is no default constructor).
+	/// </summary>
+	decltype(auto) insert(size_t place, type val) noexcept
+	{
+		new (gap(place, 1)) type(std::move(val));
+	}
+	decltype(auto) insert(size_t place, size_t count, const type& val) noexcept
+	{
+		if (&val >= p.start && &val < p.start + p.used)
 		{
-			if (p.used > 0)
-			{
-				--reinterpret_cast<type*&>(p.last);
-				--p.used;
-			}
+			type copy(val);
+			fill(gap(place, count), count, copy);
 		}
-		else if (c.use > 0)
-			--c.use;
+		else fill(gap(place, count), count, val);
 	}
-	decltype(auto) insert(size_t place, type val) noexcept
+	decltype(auto) insert(size_t place, const type* val, size_t count) noexcept
 	{
-		if (cfg & config::bit_pointer)
+		if (val + count > p.start && val < p.start + p.used)
+			return insert(place, Vector(count, val));
+		clone(gap(place, count), val, count);
+	}
+	/// <summary>
+	///	Inserting the range (forward iterators) before place.
+	///	Contiguous ranges go to insert(place, val, count), other ranges into the vector itself through a temporary.
+	/// </summary>
+	template <typename it, typename = forward<it>>
+	decltype(auto) insert(size_t place, it first, it last) noexcept
+	{
+		size_t count = std::distance(first, last);
+		if constexpr (contiguous<it>())
 		{
-			if (place >= p.allocated)
-			{
-				allocate((p.used = place) * mul_alloc + 1);
-				*p.last = val;
-			}
-			else if (place > p.used)
-			{
-				*(p.last = p.start + (p.used = place)) = val;
-			}
-			else p.start[place] = val;
+			if (count)
+				insert(place, static_cast<const type*>(std::addressof(*first)), count);
 		}
-		else
+		else if (inside(first, last))
 		{
-			if (place >= max_elements())
-			{
-				allocate((p.used = place) * mul_alloc + 1);
-				*p.last = val;
-			}
-			else if (place > c.use)
-			{
-				c.use = place;
-				*c.last() = val;
-			}
-			else c.start()[place] = val;
+			Vector t(count);
+			clone(t.p.start, first, last);
+			t.p.used = size_type(count);
+			insert(place, std::move(t));
 		}
+		else clone(gap(place, count), first, last);
+	}
+	decltype(auto) insert(size_t place, Vector&& v) noexcept
+	{
+		v.detach();
+		relocate(gap(place, v.p.used), v.p.start, v.p.used);
+		v.p.used = 0;
+	}
+	/// <summary>
+	///	Removes the elements [first, last), the tail is moved once.
+	/// </summary>
+	decltype(auto) erase(size_t first, size_t last) noexcept
+	{
+		if (last > p.used)
+			last = p.used;
+		if (first >= last)
+			return;
+		detach();
+		destroy(p.start + first, p.start + last);
+		shift(p.start + first, p.start + last, p.used - last);
+		p.used -= size_type(last - first);
+	}
+	decltype(auto) erase(size_t i) noexcept
+	{
+		erase(i, i + 1);
 	}
-	decltype(auto) insert(size_t place, type* val, size_t count) noexcept
+	/// <summary>
+	///	Appends count elements, the block grows at most once.
+	///	val can point into the vector itself.
+	/// </summary>
+	decltype(auto) append(const type* val, size_t count) noexcept
 	{
-		if (cfg & config::bit_pointer)
+		detach();
+		if (p.used + count > p.allocated)
 		{
-			if (place + count >= p.allocated)
-				allocate((p.used = place + count) * mul_alloc + 1);
-		}
-		else if (place + count >= max_elements())
-			allocate((p.used = place + count) * mul_alloc + 1);
-
-		if (cfg & config::bit_pointer)
+			size_t self = val >= p.start && val < p.start + p.used ? val - p.start : size_t(-1);
+			allocate(next(p.allocated, p.used + count));
+			if (self != size_t(-1))
+				val = p.start + self;
+		}
+		clone(p.start + p.used, val, count);
+		p.used += size_type(count);
+	}
+	/// <summary>
+	///	Appends the range of a known size (forward iterators), the block grows at most once.
+	///	Contiguous ranges are appended by append(val, count), other ranges into the vector itself through a temporary.
+	/// </summary>
+	template <typename it, typename = forward<it>>
+	decltype(auto) append(it first, it last) noexcept
+	{
+		size_t count = std::distance(first, last);
+		if constexpr (contiguous<it>())
 		{
-			memcpy(reinterpret_cast<type*&>(p.start) + place, val, count * sizeof(type));
-			p.last = reinterpret_cast<type*>(p.start) + p.used;
+			if (count)
+				append(static_cast<const type*>(std::addressof(*first)), count);
 		}
 		else
 		{
-			memcpy(p.start() + place, val, count * sizeof(type));
-			if (place + count > c.use)
-				c.use = place + count;
+			detach();
+			if (p.used + count > p.allocated)
+			{
+				if (inside(first, last))
+				{
+					Vector t(count);
+					clone(t.p.start, first, last);
+					t.p.used = size_type(count);
+					return append(std::move(t));
+				}
+				allocate(next(p.allocated, p.used + count));
+			}
+			clone(p.start + p.used, first, last);
+			p.used += size_type(count);
 		}
 	}
-	decltype(auto) size() noexcept
+	decltype(auto) append(const Vector& v) noexcept
 	{
-		if (cfg & config::bit_pointer)
-			return p.used;
-		else return size_t(c.use);
+		append(v.p.start, v.p.used);
 	}
-	decltype(auto) copy(Vector<type>* v) noexcept
+	/// <summary>
+	///	Empty vector takes the heap block of v, otherwise the elements of v are relocated, v is left empty.
+	/// </summary>
+	decltype(auto) append(Vector&& v) noexcept
 	{
-		if (cfg & config::bit_pointer)
+		if (&v == this)
+			return;
+		if (!p.used && v.heap() && v.p.start)
 		{
+			free();
+			p = v.p;
+			v.p.start = v.container();
+			v.p.used = 0;
+			v.p.allocated = size_type(max_elements());
+			return;
+		}
+		v.detach();
+		detach();
+		if (p.used + v.p.used > p.allocated)
+			allocate(next(p.allocated, p.used + v.p.used));
+		relocate(p.start + p.used, v.p.start, v.p.used);
+		p.used += v.p.used;
+		v.p.used = 0;
+	}
+	decltype(auto) size() const noexcept
+	{
+		return size_t(p.used);
+	}
+	/// <summary>
+	///	With Allocator::Shared the heap block is shared with v, not copied.
+	/// </summary>
+	decltype(auto) copy(Vector* v) const noexcept
+	{
+		if constexpr (traits::shared)
+			if (const_cast<Vector*>(this)->heap() && p.start && v != this)
+			{
+				v->free();
+				allocator::share(p.start);
+				v->p = p;
+				return;
+			}
+		v->clear();
+		if (p.allocated > v->p.allocated)
 			v->allocate(p.allocated);
-			if (p.used)
-				memcpy(v->p.start, p.start, (v->p.used = p.used) * sizeof(type));
-		}
-		else if (c.use)
-			memcpy(v->c.start(), c.start(), (v->c.use = c.use) * sizeof(type));
+		clone(v->data(), data(), size());
+		v->used(size());
 	}
+	/// <summary>
+	///	A shared block is let go (free()), not copied to be cleared.
+	/// </summary>
 	decltype(auto) clear() noexcept
 	{
-		if (cfg & config::bit_pointer)
-		{
-			p.last = p.start;
-			p.used = 0;
-		}
-		else c.use = 0;
+		if (shared())
+			return free();
+		destroy(data(), data() + size());
+		used(0);
 	}
 	decltype(auto) back() noexcept
 	{
-		if (cfg & config::bit_pointer)
-			return *reinterpret_cast<type*>(p.last);
-		else return *c.last();
+		detach();
+		return p.start[p.used - 1];
 	}
-	decltype(auto) capacity() noexcept
+	decltype(auto) capacity() const noexcept
 	{
-		if (cfg & config::bit_pointer)
-			return p.allocated;
-		else max_elements();
+		return size_t(p.allocated);
 	}
 	decltype(auto) data() noexcept
 	{
-		if (cfg & config::bit_pointer)
-			return reinterpret_cast<type*>(p.start);
-		else return c.start();
+		detach();
+		return p.start;
 	}
-	decltype(auto) swap(Vector<type>& v) noexcept
+	decltype(auto) data() const noexcept
 	{
-		std::swap(*this, v);
+		return static_cast<const type*>(p.start);
+	}
+	/// <summary>
+	///	Two heap blocks exchange the pointers, inline elements are relocated.
+	/// </summary>
+	decltype(auto) swap(Vector& v) noexcept
+	{
+		if (&v == this)
+			return;
+		if (heap() && v.heap())
+			std::swap(p, v.p);
+		else
+		{
+			Vector t(std::move(v));
+			v.take(*this);
+			take(t);
+		}
 	}
-	decltype(auto) empty() noexcept
+	decltype(auto) empty() const noexcept
 	{
-		if (cfg & config::bit_pointer)
-			return p.used == 0;
-		else return c.use == 0;
+		return p.used == 0;
 	}
 	decltype(auto) resize(size_t sz) noexcept
 	{
-		if (!(cfg & config::bit_pointer) && sz > max_elements())
+		size_t used = size();
+		if (sz > capacity())
 			allocate(sz);
 
-		if (cfg & config::bit_pointer)
-		{
-			if ((p.used = sz) <= p.allocated)
-				reinterpret_cast<type*&>(p.last) = reinterpret_cast<type*>(p.start) + p.used;
-			else allocate(p.used);
-		}
-		else c.use = sz;
-	}
+		if (sz > used)
+			construct(data() + used, data() + sz);
+		else destroy(data() + sz, data() + used);
+		this->used(sz);
+	}
+	/// <summary>
+	///	A shared block only loses this owner, the last one ends the elements and frees it.
+	/// </summary>
 	decltype(auto) free() noexcept
 	{
-		p.allocated = p.used = 0;
-		if (cfg & config::bit_pointer && p.start)
-			delete[] p.start;
-		p.last = p.start = nullptr;
+		if (!heap() || !p.start || traits::release(p.start))
+		{
+			destroy(p.start, p.start + p.used);
+			if (heap() && p.start)
+			{
+				ULTIMAAPI_TRACE(begin, p.allocated, 0, 0, sizeof(type));
+				allocator::deallocate(p.start, p.allocated * sizeof(type));
+				Statistics::deallocation<statistics_key>();
+				ULTIMAAPI_TRACE(free, p.allocated, 0, 0, sizeof(type));
+			}
+		}
+		p.start = container();
+		p.used = 0;
+		p.allocated = size_type(max_elements());
 	}
+	/// <summary>
+	///	Only grows the block, a smaller sz does nothing (shrink_to_fit() shrinks).
+	/// </summary>
 	decltype(auto) reserve(size_t sz) noexcept
 	{
-		allocate(sz);
-	}
-	decltype(auto) rate(double val) noexcept
-	{
-		return double&&(mul_alloc = val);
-	}
-	decltype(auto) rate() noexcept
-	{
-		return double&&(mul_alloc);
+		if (sz > capacity())
+			allocate(sz);
 	}
-	decltype(auto) max_size() noexcept
+	/// <summary>
+	///	Limit of the size_type counters, a larger allocate()/resize()/reserve() fails with std::length_error (terminates).
+	/// </summary>
+	static constexpr size_t max_size() noexcept
 	{
-		return (1 << (8 * sizeof(p.allocated))) / sizeof(type);
+		size_t count = size_type(-1);
+		return count < size_t(-1) / sizeof(type) ? count : size_t(-1) / sizeof(type);
 	}
 	decltype(auto) size_of() noexcept
 	{
@@ -309,33 +753,27 @@ public:
 	}
 	decltype(auto) shrink_to_fit() noexcept
 	{
-		if (cfg & config::bit_pointer && p.used < p.allocated)
+		if (heap() && p.used < p.allocated)
 			allocate(p.used);
 	}
 
 	decltype(auto) begin() noexcept
 	{
-		if (cfg & config::bit_pointer)
-			return iterator(reinterpret_cast<type*>(p.start));
-		else return iterator(c.start());
+		detach();
+		return iterator(p.start);
 	}
 	decltype(auto) end() noexcept
 	{
-		if (cfg & config::bit_pointer)
-			return iterator(reinterpret_cast<type*>(p.start) + p.used);
-		else return iterator(c.last());
+		detach();
+		return iterator(p.start + p.used);
 	}
 	decltype(auto) cbegin() const noexcept
 	{
-		if (cfg & config::bit_pointer)
-			return const_iterator(reinterpret_cast<type*>(p.start));
-		else return const_iterator(c.start());
+		return const_iterator(data());
 	}
 	decltype(auto) cend() const noexcept
 	{
-		if (cfg & config::bit_pointer)
-			return const_iterator(reinterpret_cast<type*>(p.start) + p.used);
-		else return const_iterator(c.last());
+		return const_iterator(data() + size());
 	}
 	decltype(auto) rbegin() noexcept
 	{
@@ -356,19 +794,17 @@ public:
 
 	decltype(auto) operator()(std::initializer_list<type> v) noexcept
 	{
-		if (v.size() > max_elements())
-		{
-			p.start = nullptr;
-			allocate(p.used = v.size());
-			memcpy(p.start, v.begin(), p.used * sizeof(type));
-		}
-		else memcpy(c.start(), v.begin(), (c.use = v.size()) * sizeof(type));
+		clear();
+		if (v.size() > capacity())
+			allocate(v.size());
+		clone(data(), v.begin(), v.size());
+		used(v.size());
 	}
 	decltype(auto) operator~() noexcept
 	{
 		free();
 	}
-	decltype(auto) operator^=(Vector<type>& v) noexcept
+	decltype(auto) operator^=(Vector& v) noexcept
 	{
 		swap(v);
 	}
@@ -376,181 +812,79 @@ public:
 	{
 		push_back(c);
 	}
-	decltype(auto) operator+=(Vector<type> v) noexcept
-	{
-		void* s;
-		size_t t;
-		if (v.cfg & config::bit_pointer)
-		{
-			t = v.p.used;
-			s = v.p.start;
-		}
-		else
-		{
-			t = v.c.use;
-			s = v.c.start();
-		}
-
-		if (cfg & config::bit_pointer)
-			insert(p.used, s, t);
-		else insert(c.use, s, t);
-	}
-	decltype(auto) operator+=(Vector<type>& v) noexcept
-	{
-		void* s;
-		size_t t;
-		if (v.cfg & config::bit_pointer)
-		{
-			t = v.p.used;
-			s = v.p.start;
-		}
-		else
-		{
-			t = v.c.use;
-			s = v.c.start();
-		}
-
-		if (cfg & config::bit_pointer)
-			insert(p.used, s, t);
-		else insert(c.use, s, t);
-	}
-	decltype(auto) operator+=(Vector<type>&& v) noexcept
+	decltype(auto) operator+=(const Vector& v) noexcept
 	{
-		void* s;
-		size_t t;
-		if (v.cfg & config::bit_pointer)
-		{
-			t = v.p.used;
-			s = v.p.start;
-		}
-		else
-		{
-			t = v.c.use;
-			s = v.c.start();
-		}
-
-		if (cfg & config::bit_pointer)
-			insert(p.used, s, t);
-		else insert(c.use, s, t);
-	}
-	decltype(auto) operator+=(const Vector<type> v) const  noexcept
-	{
-		void* s;
-		size_t t;
-		if (v.cfg & config::bit_pointer)
-		{
-			t = v.p.used;
-			s = v.p.start;
-		}
-		else
-		{
-			t = v.c.use;
-			s = v.c.start();
-		}
-
-		if (cfg & config::bit_pointer)
-			insert(p.used, s, t);
-		else insert(c.use, s, t);
-	}
-	decltype(auto) operator+=(const Vector<type>& v) const noexcept
-	{
-		void* s;
-		size_t t;
-		if (v.cfg & config::bit_pointer)
-		{
-			t = v.p.used;
-			s = v.p.start;
-		}
-		else
-		{
-			t = v.c.use;
-			s = v.c.start();
-		}
-
-		if (cfg & config::bit_pointer)
-			insert(p.used, s, t);
-		else insert(c.use, s, t);
+		append(v);
 	}
-	decltype(auto) operator+=(const Vector<type>&& v) const noexcept
+	decltype(auto) operator+=(Vector&& v) noexcept
 	{
-		void* s;
-		size_t t;
-		if (v.cfg & config::bit_pointer)
-		{
-			t = v.p.used;
-			s = v.p.start;
-		}
-		else
-		{
-			t = v.c.use;
-			s = v.c.start();
-		}
-
-		if (cfg & config::bit_pointer)
-			insert(p.used, s, t);
-		else insert(c.use, s, t);
+		append(std::move(v));
 	}
 	decltype(auto) operator[](size_t i) noexcept
 	{
-		if (cfg & config::bit_pointer && i >= p.allocated || !(cfg & config::bit_pointer) && i >= max_elements())
-			allocate(i * mul_alloc + 1);
-		if (cfg & config::bit_pointer)
-		{
+		detach();
+		if constexpr (std::is_default_constructible<type>::value)
 			if (i >= p.used)
 			{
-				p.used = i + 1;
-				p.last = reinterpret_cast<type*&>(p.start) + p.used;
+				if (i >= p.allocated)
+					allocate(next(p.allocated, i + 1));
+				construct(p.start + p.used, p.start + i + 1);
+				p.used = size_type(i + 1);
 			}
-			return reinterpret_cast<type*&>(p.start)[i];
-		}
-		else
-		{
-			c.use = i >= c.use ? i + 1 : c.use;
-			return c.start()[i];
-		}
+		return p.start[i];
+	}
+	/// <summary>
+	///	Reads without extending the vector (and without detaching a shared block).
+	/// </summary>
+	decltype(auto) operator[](size_t i) const noexcept
+	{
+		return static_cast<const type&>(p.start[i]);
 	}
 
-	Vector(std::initializer_list<type> v) noexcept
+	Vector(std::initializer_list<type> v) noexcept : Vector()
 	{
-		cfg = config::bit_init;
-		if (!max_elements())
-			cfg |= config::bit_always_using_pointer | config::bit_pointer;
 		this->operator()(v);
 	}
 	Vector() noexcept
 	{
-		cfg = config::bits_clear;
-		if (!max_elements())
-			cfg |= config::bit_always_using_pointer | config::bit_pointer;
-		p.last = p.start = nullptr;
-		p.allocated = p.used = 0;
+		p.start = container();
+		p.used = 0;
+		p.allocated = size_type(max_elements());
 	}
-	Vector(size_t sz) noexcept
+	Vector(size_t sz) noexcept : Vector()
 	{
-		p.used = 0;
-		p.start = nullptr;
-		cfg = config::bit_init;
-		if (!max_elements())
-			cfg |= config::bit_always_using_pointer | config::bit_pointer;
 		allocate(sz);
 	}
-	Vector(size_t sz, type* ray) noexcept
+	Vector(size_t sz, const type* ray) noexcept : Vector()
 	{
-		p.used = 0;
-		p.start = nullptr;
-		cfg = config::bit_init;
-		if (!max_elements())
-			cfg |= config::bit_always_using_pointer | config::bit_pointer;
 		insert(0, ray, sz);
 	}
-	Vector(Vector<type>& v) noexcept
+	Vector(const Vector& v) noexcept : Vector()
 	{
-		cfg = config::bit_init;
 		v.copy(this);
 	}
+	Vector(Vector&& v) noexcept : Vector()
+	{
+		take(v);
+	}
+	Vector& operator=(const Vector& v) noexcept
+	{
+		if (&v != this)
+			v.copy(this);
+		return *this;
+	}
+	Vector& operator=(Vector&& v) noexcept
+	{
+		if (&v != this)
+		{
+			free();
+			take(v);
+		}
+		return *this;
+	}
 
 	~Vector() noexcept
 	{
 		free();
 	}
-};
+};
\ No newline at end of file
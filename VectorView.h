@@ -0,0 +1,127 @@
+#pragma once
+
+#include <stddef.h>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "../BasicIterator/BasicIterator.h"
+
+namespace UltimaAPI
+{
+	template <typename type>  class VectorView;
+}
+
+/// <summary>
+///	Non-owning view of count contiguous elements (pointer + length), VectorView<const type> for reading.
+///	Made from any container with data() and size(): Vector (inline or heap), MultidimensionalVector, MappedVector, ...
+///	(a strided MultidimensionalView only when it is contiguous()).
+///	subview(), first() and last() only move the pointer, nothing is copied.
+///	The view is valid while the container keeps its block: growing, shrinking or freeing the container
+///	(and the first change of a shared Allocator::Shared copy) invalidates it.
+///	A mutable view of a Vector is taken through its non-const data(), a shared block is detached then.
+/// </summary>
+template <typename type>
+class UltimaAPI::VectorView
+{
+	type* start;
+	size_t used;
+public:
+	using iterator = BasicIterator<type>;
+	using const_iterator = BasicIterator<const type>;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	decltype(auto) size() const noexcept
+	{
+		return used;
+	}
+	decltype(auto) empty() const noexcept
+	{
+		return used == 0;
+	}
+	decltype(auto) data() const noexcept
+	{
+		return start;
+	}
+	decltype(auto) operator[](size_t i) const noexcept
+	{
+		return start[i];
+	}
+	decltype(auto) front() const noexcept
+	{
+		return start[0];
+	}
+	decltype(auto) back() const noexcept
+	{
+		return start[used - 1];
+	}
+
+	/// <summary>
+	///	count elements from offset, cut at the end of the view.
+	/// </summary>
+	decltype(auto) subview(size_t offset, size_t count = size_t(-1)) const noexcept
+	{
+		if (offset > used)
+			offset = used;
+		return VectorView(start + offset, count < used - offset ? count : used - offset);
+	}
+	decltype(auto) first(size_t count) const noexcept
+	{
+		return subview(0, count);
+	}
+	decltype(auto) last(size_t count) const noexcept
+	{
+		return subview(count < used ? used - count : 0);
+	}
+
+	decltype(auto) begin() const noexcept
+	{
+		return iterator(start);
+	}
+	decltype(auto) end() const noexcept
+	{
+		return iterator(start + used);
+	}
+	decltype(auto) cbegin() const noexcept
+	{
+		return const_iterator(start);
+	}
+	decltype(auto) cend() const noexcept
+	{
+		return const_iterator(start + used);
+	}
+	decltype(auto) rbegin() const noexcept
+	{
+		return reverse_iterator(end());
+	}
+	decltype(auto) rend() const noexcept
+	{
+		return reverse_iterator(begin());
+	}
+	decltype(auto) crbegin() const noexcept
+	{
+		return const_reverse_iterator(cend());
+	}
+	decltype(auto) crend() const noexcept
+	{
+		return const_reverse_iterator(cbegin());
+	}
+
+	VectorView() noexcept : start(nullptr), used(0) {}
+	VectorView(type* data, size_t count) noexcept : start(data), used(count) {}
+	/// <summary>
+	///	[first, last), a template so that VectorView(data, 0) takes the count.
+	/// </summary>
+	template <typename end_type, typename = std::enable_if_t<!std::is_integral<end_type>::value && std::is_convertible<end_type, type*>::value>>
+	VectorView(type* first, end_type last) noexcept : start(first), used(size_t(static_cast<type*>(last) - first)) {}
+	/// <summary>
+	///	View of all elements of the container (a mutable view converts to a const one the same way).
+	/// </summary>
+	template <typename container, typename = std::enable_if_t<
+		std::is_convertible<decltype(std::declval<container&>().data()), type*>::value &&
+		!std::is_same<std::remove_cv_t<container>, VectorView>::value>>
+	VectorView(container& c) noexcept : start(c.data()), used(size_t(c.size())) {}
+	template <typename other, typename = std::enable_if_t<std::is_convertible<other*, type*>::value>>
+	VectorView(const VectorView<other>& v) noexcept : start(v.data()), used(v.size()) {}
+};
@@ -176,7 +176,7 @@ public:
 	/// <param name="i">Index</param>
 	decltype(auto) at(size_t i) const
 	{
-		return const reference(start[i]);
+		return static_cast<const value&>(start[i]);
 	}
 	/// <summary>
 	///	Inserting an element at the end of a data block.
@@ -246,7 +246,7 @@ public:
 	decltype(auto) move_insert(size_t place, rvalue val)
 	{
 		if (insert_correct(place))
-			Memory::memcpy(start + place + 1, start + place, used - place);
+			memmove(start + place + 1, start + place, (used - place) * size_value());
 		start[place] = val;
 	}
 	/// <summary>
@@ -261,8 +261,8 @@ public:
 	{
 		auto place_address = start + place;
 		if (insert_correct(place, count))
-			Memory::memcpy(place_address + count, place_address, used - place);
-		Memory::memcpy(place_address, val, count * size_value());
+			memmove(place_address + count, place_address, (used - place) * size_value());
+		memcpy(place_address, val, count * size_value());
 	}
 	/// <summary>
 	///	HIGH TIME CONSUMPTION FUNCTION (memcpy)
@@ -640,7 +640,9 @@ public:
 	/// <param name="v">Vector<value> rvalue</param>
 	decltype(auto) swap(vector_rvalue v) noexcept
 	{
-		std::swap(*this, v);
+		std::swap(used, v.used);
+		std::swap(allocated, v.allocated);
+		std::swap(start, v.start);
 	}
 	/// <summary>
 	///	Swaps the contents const Vectors
@@ -967,12 +969,14 @@ public:
 		v.copy(this);
 	}
 	/// <summary>
-	///	CONSTRUCTOR copy
+	///	CONSTRUCTOR move
+	///	Takes the data block, v is left empty.
 	/// </summary>
-	/// <param name="v">reference to vector</param>
-	Vector(vector_rvalue v) noexcept
+	/// <param name="v">rvalue to vector</param>
+	Vector(vector_rvalue v) noexcept : used(v.used), allocated(v.allocated), start(v.start)
 	{
-		v.copy(this);
+		v.start = nullptr;
+		v.allocated = v.used = 0;
 	}
 	/// <summary>
 	///	DESTRUCTOR